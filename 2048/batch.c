@@ -0,0 +1,251 @@
+#define _DEFAULT_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "expectimax.h"
+#include "game.h"
+
+// Headless batch runner.
+//
+// Plays many seeded games without a terminal, spread over worker threads,
+// and reports games/s, moves/s, the score and the distribution of the
+// biggest tile reached. Game i is seeded with seed + i and the policy
+// draws only from a stream derived from that seed, so every result and
+// the digest printed at the end are the same for any number of threads.
+//
+//   ./2048_batch [--games N] [--threads N] [--seed N]
+//                [--policy random|greedy|corner|expectimax] [--depth K]
+
+#define CHUNK 64            // games a worker takes at a time
+#define BATCH_TABLE_BITS 16 // expectimax transposition table per thread
+
+enum { POLICY_RANDOM, POLICY_GREEDY, POLICY_CORNER, POLICY_EXPECTIMAX };
+static const char *policy_names[] = {"random", "greedy", "corner", "expectimax"};
+
+static long games = 1000000;
+static uint64_t seed = 1;
+static int policy = POLICY_RANDOM;
+static int depth = 2;
+
+static long next_game = 0; // first game no worker has taken yet
+
+typedef struct {
+  long games;
+  long moves;
+  double score;
+  long tiles[MAX_RANK + 1]; // games by biggest tile
+  uint64_t digest;          // sum of per-game hashes, so order does not matter
+} Stats;
+
+static double now_seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Any move that changes the board, uniformly
+static int random_policy(Board b, uint64_t *state) {
+  int dirs[4], n = 0;
+  for (int d = 0; d < 4; d++) {
+    if (board_move(b, d, NULL) != b)
+      dirs[n++] = d;
+  }
+  return dirs[random64(state) % n];
+}
+
+// The move scoring most now, then the one leaving most empty cells
+static int greedy_policy(Board b) {
+  int best = -1, best_score = -1, best_empty = -1;
+  for (int d = 0; d < 4; d++) {
+    int gained = 0;
+    Board next = board_move(b, d, &gained);
+    if (next == b)
+      continue;
+    int empty = board_empty(next);
+    if (gained > best_score || (gained == best_score && empty > best_empty)) {
+      best = d;
+      best_score = gained;
+      best_empty = empty;
+    }
+  }
+  return best;
+}
+
+// Keep the big tiles in the bottom left corner: down, then left, then
+// right, and up only when nothing else moves
+static int corner_policy(Board b) {
+  static const int order[4] = {DIR_DOWN, DIR_LEFT, DIR_RIGHT, DIR_UP};
+  for (int i = 0; i < 4; i++) {
+    if (board_move(b, order[i], NULL) != b)
+      return order[i];
+  }
+  return -1;
+}
+
+static void play(Game *g, Search *s, uint64_t game_seed) {
+  uint64_t player = ~game_seed;
+  init_game(g, game_seed);
+  if (policy == POLICY_EXPECTIMAX)
+    search_clear(s);
+  while (!g->game_over) {
+    int dir;
+    switch (policy) {
+    case POLICY_RANDOM:
+      dir = random_policy(g->board, &player);
+      break;
+    case POLICY_GREEDY:
+      dir = greedy_policy(g->board);
+      break;
+    case POLICY_CORNER:
+      dir = corner_policy(g->board);
+      break;
+    default:
+      dir = search_best(s, g->board, depth);
+      break;
+    }
+    // Every policy has a move while the game is not over; anything else
+    // would spin here forever
+    if (dir < 0) {
+      fprintf(stderr, "%s policy found no move on board %016llx (seed %llu)\n", policy_names[policy],
+              (unsigned long long)g->board, (unsigned long long)game_seed);
+      abort();
+    }
+    game_move(g, dir);
+  }
+}
+
+// Each worker allocates one transposition table and clears it per game,
+// so a game plays the same whichever thread runs it
+static void *worker(void *arg) {
+  Stats st = {0}; // copied out at the end, not shared while counting
+  Game g;
+  Search s;
+  if (policy == POLICY_EXPECTIMAX)
+    search_init(&s, BATCH_TABLE_BITS);
+
+  while (1) {
+    long first = __atomic_fetch_add(&next_game, CHUNK, __ATOMIC_RELAXED);
+    if (first >= games)
+      break;
+    long last = first + CHUNK < games ? first + CHUNK : games;
+    for (long i = first; i < last; i++) {
+      play(&g, &s, seed + i);
+      int rank = board_max_rank(g.board);
+      st.games++;
+      st.moves += g.moves;
+      st.score += g.score;
+      st.tiles[rank]++;
+      uint64_t h = g.board ^ ((uint64_t)g.score << 32 ^ (uint64_t)g.moves) ^ (uint64_t)i;
+      st.digest += random64(&h);
+    }
+  }
+
+  if (policy == POLICY_EXPECTIMAX)
+    search_free(&s);
+  *(Stats *)arg = st;
+  return NULL;
+}
+
+// A count with an optional k or M suffix
+static long parse_count(const char *s) {
+  char *end;
+  double n = strtod(s, &end);
+  if (*end == 'k' || *end == 'K')
+    n *= 1e3, end++;
+  else if (*end == 'M' || *end == 'm')
+    n *= 1e6, end++;
+  return *end ? -1 : (long)n;
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "usage: %s [--games N] [--threads N] [--seed N]\n"
+          "       %*s [--policy random|greedy|corner|expectimax] [--depth K]\n",
+          prog, (int)strlen(prog), "");
+  fprintf(stderr, "  --games N         games to play, k and M suffixes allowed (default 1M)\n");
+  fprintf(stderr, "  --threads N       worker threads (default: one per CPU)\n");
+  fprintf(stderr, "  --seed N          game i is seeded with N + i (default 1)\n");
+  fprintf(stderr, "  --policy P        how moves are chosen (default random)\n");
+  fprintf(stderr, "  --depth K         moves expectimax looks ahead (default 2)\n");
+}
+
+int main(int argc, char **argv) {
+  int threads = 0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+      games = parse_count(argv[++i]);
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = strtoull(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+      i++;
+      policy = -1;
+      for (int p = 0; p < 4; p++) {
+        if (strcmp(argv[i], policy_names[p]) == 0)
+          policy = p;
+      }
+      if (policy < 0)
+        games = 0;
+    } else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+      depth = atoi(argv[++i]);
+    } else {
+      games = 0;
+    }
+  }
+  if (games < 1 || depth < 1 || threads < 0) {
+    usage(argv[0]);
+    return 1;
+  }
+  if (threads == 0)
+    threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (threads < 1)
+    threads = 1;
+
+  board_init_tables();
+  Stats *stats = calloc(threads, sizeof(Stats));
+  pthread_t *workers = malloc(sizeof(pthread_t) * threads);
+  if (policy == POLICY_EXPECTIMAX)
+    printf("%ld games, expectimax depth %d, %d threads\n", games, depth, threads);
+  else
+    printf("%ld games, %s, %d threads\n", games, policy_names[policy], threads);
+
+  double start = now_seconds();
+  for (int t = 0; t < threads; t++)
+    pthread_create(&workers[t], NULL, worker, &stats[t]);
+  for (int t = 0; t < threads; t++)
+    pthread_join(workers[t], NULL);
+  double secs = now_seconds() - start;
+
+  Stats total = {0};
+  for (int t = 0; t < threads; t++) {
+    total.games += stats[t].games;
+    total.moves += stats[t].moves;
+    total.score += stats[t].score;
+    total.digest += stats[t].digest;
+    for (int r = 0; r <= MAX_RANK; r++)
+      total.tiles[r] += stats[t].tiles[r];
+  }
+
+  printf("wall %.3f s, %.0f games/s, %.2f M moves/s (%.0f moves per game)\n", secs,
+         total.games / secs, total.moves / secs / 1e6, (double)total.moves / total.games);
+  printf("score mean %.1f\n", total.score / total.games);
+  printf("%8s %12s %8s %10s\n", "max tile", "games", "%", "reached %");
+  long reached = total.games;
+  for (int r = 0; r <= MAX_RANK; r++) {
+    if (total.tiles[r] > 0)
+      printf("%8d %12ld %8.3f %10.3f\n", 1 << r, total.tiles[r], 100.0 * total.tiles[r] / total.games,
+             100.0 * reached / total.games);
+    reached -= total.tiles[r];
+  }
+  printf("digest %016llx\n", (unsigned long long)total.digest);
+
+  free(workers);
+  free(stats);
+  return 0;
+}
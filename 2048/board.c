@@ -0,0 +1,124 @@
+#include "board.h"
+
+#include <stddef.h>
+
+#define ROW_MASK 0xffffULL
+#define COL_MASK 0x000f000f000f000fULL
+
+// Indexed by a row read left to right (nibble 0 is the left cell)
+static uint16_t row_left[65536];
+static uint16_t row_right[65536];
+static Board col_up[65536];   // row_left, laid out as a column
+static Board col_down[65536];
+static int row_score[65536];  // the same either way a line slides
+
+static uint16_t reverse_row(uint16_t row) {
+  return (row >> 12) | ((row >> 4) & 0x00f0) | ((row << 4) & 0x0f00) | (row << 12);
+}
+
+// Nibble k of `row` moved to nibble 4 * k of the board, i.e. down column 0
+static Board unpack_col(uint16_t row) {
+  Board b = row;
+  return (b | (b << 12) | (b << 24) | (b << 36)) & COL_MASK;
+}
+
+void board_init_tables(void) {
+  for (int row = 0; row < 65536; row++) {
+    int line[SIZE], out[SIZE] = {0}, n = 0, score = 0;
+    for (int i = 0; i < SIZE; i++)
+      line[i] = (row >> (4 * i)) & 0xf;
+
+    // Slide left, merging each pair of equal tiles once
+    for (int i = 0; i < SIZE; i++) {
+      if (line[i] == 0)
+        continue;
+      if (n > 0 && out[n - 1] == line[i] && line[i] != MAX_RANK) {
+        out[n - 1] = (line[i] + 1) | 0x100; // marked as merged this move
+        score += 1 << (line[i] + 1);
+      } else {
+        out[n++] = line[i];
+      }
+    }
+
+    uint16_t result = 0;
+    for (int i = 0; i < SIZE; i++)
+      result |= (out[i] & 0xf) << (4 * i);
+    uint16_t rev = reverse_row(row), rev_result = reverse_row(result);
+
+    row_left[row] = result;
+    row_right[rev] = rev_result;
+    col_up[row] = unpack_col(result);
+    col_down[rev] = unpack_col(rev_result);
+    row_score[row] = score;
+  }
+}
+
+// Rows become columns: nibble (r, c) moves to (c, r)
+Board board_transpose(Board b) {
+  Board a1 = b & 0xf0f00f0ff0f00f0fULL;
+  Board a2 = b & 0x0000f0f00000f0f0ULL;
+  Board a3 = b & 0x0f0f00000f0f0000ULL;
+  Board a = a1 | (a2 << 12) | (a3 >> 12);
+  Board b1 = a & 0xff00ff0000ff00ffULL;
+  Board b2 = a & 0x00ff00ff00000000ULL;
+  Board b3 = a & 0x00000000ff00ff00ULL;
+  return b1 | (b2 >> 24) | (b3 << 24);
+}
+
+Board board_move(Board b, int dir, int *score) {
+  Board result = 0;
+  int gained = 0;
+  if (dir < DIR_LEFT || dir > DIR_UP)
+    return b;
+  if (dir == DIR_LEFT || dir == DIR_RIGHT) {
+    const uint16_t *table = dir == DIR_LEFT ? row_left : row_right;
+    for (int r = 0; r < SIZE; r++) {
+      uint16_t row = (b >> (16 * r)) & ROW_MASK;
+      result |= (Board)table[row] << (16 * r);
+      gained += row_score[row];
+    }
+  } else {
+    const Board *table = dir == DIR_UP ? col_up : col_down;
+    Board t = board_transpose(b);
+    for (int c = 0; c < SIZE; c++) {
+      uint16_t col = (t >> (16 * c)) & ROW_MASK;
+      result |= table[col] << (4 * c);
+      gained += row_score[col];
+    }
+  }
+  if (score && result != b)
+    *score += gained;
+  return result;
+}
+
+int board_empty(Board b) {
+  // Fold each nibble onto its low bit: set where the cell is occupied
+  b |= b >> 2;
+  b |= b >> 1;
+  b &= 0x1111111111111111ULL;
+  return SIZE * SIZE - __builtin_popcountll(b);
+}
+
+Board board_spawn(Board b, int nth, int rank) {
+  for (int shift = 0; shift < 64; shift += 4) {
+    if (((b >> shift) & 0xf) == 0 && nth-- == 0)
+      return b | ((Board)rank << shift);
+  }
+  return b;
+}
+
+// A full board can move only if some line has equal neighbours, and then
+// sliding left or up shows it
+int board_can_move(Board b) {
+  return board_empty(b) > 0 || board_move(b, DIR_LEFT, NULL) != b ||
+         board_move(b, DIR_UP, NULL) != b;
+}
+
+int board_max_rank(Board b) {
+  int max = 0;
+  for (; b; b >>= 4) {
+    if ((int)(b & 0xf) > max)
+      max = b & 0xf;
+  }
+  return max;
+}
@@ -0,0 +1,43 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+// Packed 2048 board.
+//
+// The 4x4 grid is one 64-bit word of 4-bit tile exponents: cell (row, col)
+// is nibble 4 * row + col, holding 0 when empty and k for a tile of 2^k.
+// Each row is a 16-bit line, so a move is four lookups in 65536-entry
+// tables built once by board_init_tables(). Vertical moves transpose the
+// board and look its rows up in tables that write the result back as
+// columns.
+
+#include <stdint.h>
+
+#define SIZE 4
+#define MAX_RANK 15 // 32768; two of these do not merge
+
+typedef uint64_t Board;
+
+// Directions for board_move(), in the order the board used to be
+// rotated clockwise before sliding it left.
+enum { DIR_LEFT, DIR_DOWN, DIR_RIGHT, DIR_UP };
+
+void board_init_tables(void);
+
+static inline int board_tile(Board b, int row, int col) {
+  return (b >> (4 * (SIZE * row + col))) & 0xf;
+}
+
+// The board after sliding toward `dir`, which is `b` itself if nothing
+// moves or `dir` is not a direction. Adds the value of the merged tiles
+// to *score unless it is NULL.
+Board board_move(Board b, int dir, int *score);
+Board board_transpose(Board b);
+
+int board_empty(Board b);
+// `b` with a tile of rank `rank` put on its nth empty cell (from 0, in
+// row-major order).
+Board board_spawn(Board b, int nth, int rank);
+int board_can_move(Board b);
+int board_max_rank(Board b);
+
+#endif
@@ -0,0 +1,52 @@
+#include <stdio.h>
+
+#include "board.h"
+#include "expectimax.h"
+#include "game.h"
+
+// Checks that the search always suggests a move that changes the board
+// while one exists, on positions from seeded random games and on boards
+// that once made it give up.
+//
+//   make check
+
+static int failures = 0;
+
+static void check_position(Search *s, Board b, int depth) {
+  int dir = search_best(s, b, depth);
+  int legal = dir >= 0 && dir < 4 && board_move(b, dir, NULL) != b;
+  if (board_can_move(b) ? !legal : dir != -1) {
+    if (failures++ < 10)
+      printf("board %016llx depth %d: search_best returned %d\n", (unsigned long long)b, depth, dir);
+  }
+}
+
+int main() {
+  board_init_tables();
+  Search s;
+  search_init(&s, 16);
+
+  // Evaluations here were once all negative
+  static const Board known[] = {0x8640232012100000ULL};
+  for (int i = 0; i < (int)(sizeof(known) / sizeof(known[0])); i++) {
+    for (int depth = 1; depth <= 3; depth++)
+      check_position(&s, known[i], depth);
+  }
+
+  long positions = 0;
+  uint64_t rng = 1;
+  for (int n = 0; n < 200; n++) {
+    Game g;
+    init_game(&g, random64(&rng));
+    while (!g.game_over) {
+      check_position(&s, g.board, 1 + positions % 2);
+      positions++;
+      game_move(&g, random64(&rng) % 4);
+    }
+    check_position(&s, g.board, 1);
+  }
+
+  search_free(&s);
+  printf("%ld positions, %d failures\n", positions, failures);
+  return failures ? 1 : 0;
+}
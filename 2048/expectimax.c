@@ -0,0 +1,253 @@
+#define _DEFAULT_SOURCE
+#include "expectimax.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Heuristic weights, per row or column. LOST_PENALTY lifts every line so
+// live positions score above SEARCH_LOST.
+#define LOST_PENALTY 200000.0
+#define MONOTONICITY_POWER 4.0
+#define MONOTONICITY_WEIGHT 47.0
+#define SUM_POWER 3.5
+#define SUM_WEIGHT 11.0
+#define MERGES_WEIGHT 700.0
+#define EMPTY_WEIGHT 270.0
+
+static float line_value[65536];
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+static void init_line_values(void) {
+  for (int row = 0; row < 65536; row++) {
+    int line[SIZE];
+    for (int i = 0; i < SIZE; i++)
+      line[i] = (row >> (4 * i)) & 0xf;
+
+    double sum = 0;
+    int empty = 0, merges = 0, prev = 0, counter = 0;
+    for (int i = 0; i < SIZE; i++) {
+      sum += pow(line[i], SUM_POWER);
+      if (line[i] == 0) {
+        empty++;
+      } else if (prev == line[i]) {
+        counter++;
+      } else {
+        if (counter > 0)
+          merges += 1 + counter;
+        counter = 0;
+        prev = line[i];
+      }
+    }
+    if (counter > 0)
+      merges += 1 + counter;
+
+    double left = 0, right = 0;
+    for (int i = 1; i < SIZE; i++) {
+      double a = pow(line[i - 1], MONOTONICITY_POWER), b = pow(line[i], MONOTONICITY_POWER);
+      if (line[i - 1] > line[i])
+        left += a - b;
+      else
+        right += b - a;
+    }
+
+    line_value[row] = LOST_PENALTY + EMPTY_WEIGHT * empty + MERGES_WEIGHT * merges -
+                      MONOTONICITY_WEIGHT * (left < right ? left : right) - SUM_WEIGHT * sum;
+  }
+}
+
+double search_eval(Board b) {
+  Board t = board_transpose(b);
+  double value = 0;
+  for (int i = 0; i < SIZE; i++)
+    value += line_value[(b >> (16 * i)) & 0xffff] + line_value[(t >> (16 * i)) & 0xffff];
+  return value;
+}
+
+void search_init(Search *s, int table_bits) {
+  pthread_once(&tables_once, init_line_values);
+  memset(s, 0, sizeof(*s));
+  s->table = calloc((size_t)1 << table_bits, sizeof(SearchEntry));
+  s->mask = (1u << table_bits) - 1;
+}
+
+void search_free(Search *s) {
+  free(s->table);
+  memset(s, 0, sizeof(*s));
+}
+
+void search_clear(Search *s) {
+  memset(s->table, 0, ((size_t)s->mask + 1) * sizeof(SearchEntry));
+}
+
+static double chance_node(Search *s, Board b, int depth, double prob);
+
+static double max_node(Search *s, Board b, int depth, double prob) {
+  s->nodes++;
+  if (s->latest && __atomic_load_n(s->latest, __ATOMIC_RELAXED) != s->serial)
+    s->cancelled = 1;
+  if (s->cancelled)
+    return 0;
+
+  double best = -INFINITY;
+  for (int d = 0; d < 4; d++) {
+    Board next = board_move(b, d, NULL);
+    if (next == b)
+      continue;
+    double v = chance_node(s, next, depth - 1, prob);
+    if (v > best)
+      best = v;
+  }
+  return best == -INFINITY ? SEARCH_LOST : best;
+}
+
+static double chance_node(Search *s, Board b, int depth, double prob) {
+  if (prob < SEARCH_MIN_PROB)
+    return search_eval(b);
+  if (depth <= 0) {
+    s->horizon = 1;
+    return search_eval(b);
+  }
+
+  Board h = b * 0x9E3779B97F4A7C15ULL;
+  SearchEntry *e = &s->table[(h >> 32) & s->mask];
+  if (e->board == b && e->depth >= depth)
+    return e->value;
+
+  int empty = board_empty(b);
+  double total = 0;
+  for (int n = 0; n < empty; n++) {
+    total += 0.9 * max_node(s, board_spawn(b, n, 1), depth, prob * 0.9 / empty);
+    total += 0.1 * max_node(s, board_spawn(b, n, 2), depth, prob * 0.1 / empty);
+  }
+  total /= empty;
+
+  if (!s->cancelled) {
+    e->board = b;
+    e->value = total;
+    e->depth = depth;
+  }
+  return total;
+}
+
+int search_best(Search *s, Board b, int depth) {
+  int best = -1;
+  double best_value = -INFINITY;
+  s->cancelled = 0;
+  s->horizon = 0;
+  for (int d = 0; d < 4 && !s->cancelled; d++) {
+    Board next = board_move(b, d, NULL);
+    if (next == b)
+      continue;
+    double v = chance_node(s, next, depth - 1, 1.0);
+    if (v > best_value) {
+      best_value = v;
+      best = d;
+    }
+  }
+  return s->cancelled ? -1 : best;
+}
+
+// --- Background hints ---
+
+// The published result, one word so it is read and written whole:
+// request serial << 32 | depth << 8 | direction (0xff for none)
+#define PACK(serial, depth, dir) ((uint64_t)(serial) << 32 | (uint64_t)(depth) << 8 | ((dir) & 0xff))
+
+struct Hint {
+  pthread_t thread;
+  int pipe[2];          // a byte per request wakes the thread
+  Board board;          // the latest request
+  unsigned requested;   // its serial, bumped after `board` is stored
+  int quit;
+  uint64_t published;
+  long nodes;
+  Search search;
+};
+
+static void *hint_worker(void *arg) {
+  Hint *h = arg;
+  unsigned finished = 0;  // serial searched to the full depth
+  while (!__atomic_load_n(&h->quit, __ATOMIC_ACQUIRE)) {
+    unsigned serial = __atomic_load_n(&h->requested, __ATOMIC_ACQUIRE);
+    if (serial == finished) {
+      char buf[64];
+      ssize_t n = read(h->pipe[0], buf, sizeof(buf));
+      (void)n;
+      continue;
+    }
+    Board b = __atomic_load_n(&h->board, __ATOMIC_RELAXED);
+
+    // Deeper and deeper, publishing each complete answer
+    Search *s = &h->search;
+    s->latest = &h->requested;
+    s->serial = serial;
+    for (int depth = 1; depth <= HINT_MAX_DEPTH; depth++) {
+      long before = s->nodes;
+      int dir = search_best(s, b, depth);
+      __atomic_add_fetch(&h->nodes, s->nodes - before, __ATOMIC_RELAXED);
+      if (s->cancelled)
+        break;
+      __atomic_store_n(&h->published, PACK(serial, depth, dir), __ATOMIC_RELEASE);
+      // Stop once only the probability cutoff ends lines: deeper is the same
+      if (dir < 0 || !s->horizon)
+        break;
+    }
+    if (!s->cancelled)
+      finished = serial;
+  }
+  return NULL;
+}
+
+Hint *hint_create(void) {
+  Hint *h = calloc(1, sizeof(Hint));
+  if (pipe(h->pipe) != 0) {
+    free(h);
+    return NULL;
+  }
+  fcntl(h->pipe[1], F_SETFL, O_NONBLOCK);
+  search_init(&h->search, SEARCH_TABLE_BITS);
+  pthread_create(&h->thread, NULL, hint_worker, h);
+  return h;
+}
+
+void hint_destroy(Hint *h) {
+  if (!h)
+    return;
+  __atomic_store_n(&h->quit, 1, __ATOMIC_RELEASE);
+  __atomic_add_fetch(&h->requested, 1, __ATOMIC_RELEASE); // cancels the search
+  char c = 1;
+  ssize_t n = write(h->pipe[1], &c, 1);
+  (void)n;
+  pthread_join(h->thread, NULL);
+
+  close(h->pipe[0]);
+  close(h->pipe[1]);
+  search_free(&h->search);
+  free(h);
+}
+
+void hint_request(Hint *h, Board b) {
+  __atomic_store_n(&h->board, b, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&h->requested, 1, __ATOMIC_RELEASE);
+  // If the pipe is full the thread is awake anyway
+  char c = 1;
+  ssize_t n = write(h->pipe[1], &c, 1);
+  (void)n;
+}
+
+int hint_best(const Hint *h, int *depth) {
+  uint64_t p = __atomic_load_n(&h->published, __ATOMIC_ACQUIRE);
+  if ((unsigned)(p >> 32) != __atomic_load_n(&h->requested, __ATOMIC_RELAXED) || (p & 0xff) == 0xff)
+    return -1;
+  if (depth)
+    *depth = (p >> 8) & 0xff;
+  return p & 0xff;
+}
+
+long hint_nodes(const Hint *h) {
+  return __atomic_load_n(&h->nodes, __ATOMIC_RELAXED);
+}
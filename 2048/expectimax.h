@@ -0,0 +1,76 @@
+#ifndef EXPECTIMAX_H
+#define EXPECTIMAX_H
+
+// Expectimax search for 2048.
+//
+// Player nodes take the best of the four moves; chance nodes average over
+// every empty cell receiving a 2 (90%) or a 4 (10%), as add_random() does.
+// Leaves are scored by a heuristic summed from per-row tables: empty
+// cells, possible merges, monotone rows and columns, and a penalty on big
+// tiles. Branches whose probability falls below SEARCH_MIN_PROB are cut
+// off early. Chance node values are cached in a transposition table keyed
+// on the board, so positions reached by different move orders are
+// searched once.
+//
+// A Hint runs iterative deepening on a background thread. The front end
+// hands it positions and reads back the best move found so far without
+// taking a lock or ever waiting for the search.
+
+#include <stdint.h>
+
+#include "board.h"
+
+#define SEARCH_MIN_PROB 0.0001
+#define SEARCH_LOST 0.0         // value of a position with no move left
+#define SEARCH_TABLE_BITS 20    // transposition table entries, as a power of two
+#define HINT_MAX_DEPTH 10
+
+typedef struct {
+  Board board;                  // 0 marks an empty entry
+  float value;
+  int depth;                    // moves searched below this chance node
+} SearchEntry;
+
+typedef struct {
+  SearchEntry *table;
+  unsigned mask;
+  long nodes;
+  // Give up once *latest differs from serial; latest may be NULL
+  const unsigned *latest;
+  unsigned serial;
+  int cancelled;
+  int horizon;                  // the last search stopped some line for depth
+} Search;
+
+// board_init_tables() must have run first.
+void search_init(Search *s, int table_bits);
+void search_free(Search *s);
+// Forget the cached positions. Cached values also depend on the branch
+// probability that reached them, so searches only repeat exactly from a
+// cleared table.
+void search_clear(Search *s);
+
+// Heuristic value of a position; above SEARCH_LOST for boards met in play.
+double search_eval(Board b);
+
+// The best direction from `b` looking `depth` moves ahead, or -1 if no
+// move is possible or the search was cancelled (s->cancelled is set).
+int search_best(Search *s, Board b, int depth);
+
+typedef struct Hint Hint;
+
+Hint *hint_create(void);
+void hint_destroy(Hint *h);
+
+// Search `b` from now on, abandoning whatever the thread was doing.
+// Never blocks.
+void hint_request(Hint *h, Board b);
+
+// Best direction found so far for the latest request and the depth it
+// came from, or -1 while there is none yet.
+int hint_best(const Hint *h, int *depth);
+
+// Positions the thread has searched since it started.
+long hint_nodes(const Hint *h);
+
+#endif
@@ -0,0 +1,43 @@
+#include "game.h"
+
+uint64_t random64(uint64_t *state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+void init_game(Game *g, uint64_t seed) {
+  g->board = 0;
+  g->score = 0;
+  g->won = 0;
+  g->game_over = 0;
+  g->moves = 0;
+  g->rng = seed;
+  add_random(g);
+  add_random(g);
+}
+
+void add_random(Game *g) {
+  int count = board_empty(g->board);
+  if (count > 0) {
+    int r = random64(&g->rng) % count;
+    g->board = board_spawn(g->board, r, (random64(&g->rng) % 10 == 0) ? 2 : 1);
+  }
+}
+
+int can_move(const Game *g) { return board_can_move(g->board); }
+
+int game_move(Game *g, int dir) {
+  Board next = board_move(g->board, dir, &g->score);
+  if (next == g->board)
+    return 0;
+  g->board = next;
+  g->moves++;
+  if ((1 << board_max_rank(g->board)) >= WIN_VALUE)
+    g->won = 1;
+  add_random(g);
+  if (!can_move(g))
+    g->game_over = 1;
+  return 1;
+}
@@ -0,0 +1,37 @@
+#ifndef GAME_H
+#define GAME_H
+
+// 2048 rules around a Board: score, win and game-over flags, and the
+// tile spawns. All state lives in a Game with its own seeded generator,
+// so several games can run side by side and a seed replays a game.
+
+#include <stdint.h>
+
+#include "board.h"
+
+#define WIN_VALUE 2048
+
+typedef struct {
+  Board board;
+  int score;
+  int won;
+  int game_over;
+  int moves;
+  uint64_t rng;
+} Game;
+
+// splitmix64 step on `*state`
+uint64_t random64(uint64_t *state);
+
+// An empty board with two tiles, drawn from `seed`
+void init_game(Game *g, uint64_t seed);
+
+// A 2 (90%) or a 4 (10%) on a uniformly chosen empty cell
+void add_random(Game *g);
+int can_move(const Game *g);
+
+// Slide toward `dir`. If anything moved, adds a tile, updates the flags
+// and returns 1.
+int game_move(Game *g, int dir);
+
+#endif
@@ -1,105 +1,20 @@
 #define _DEFAULT_SOURCE
 #include <ncurses.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
-#define SIZE 4
-#define WIN_VALUE 2048
+#include "board.h"
+#include "expectimax.h"
+#include "game.h"
 
-int board[SIZE][SIZE];
-int score = 0;
-int max_score = 0;
-int won = 0;
-int game_over = 0;
+#define HINT_POLL_MS 100
 
-void init_board() {
-  memset(board, 0, sizeof(board));
-  score = 0;
-  won = 0;
-  game_over = 0;
-}
-
-void add_random() {
-  int empty[SIZE * SIZE][2];
-  int count = 0;
-  for (int i = 0; i < SIZE; i++) {
-    for (int j = 0; j < SIZE; j++) {
-      if (board[i][j] == 0) {
-        empty[count][0] = i;
-        empty[count][1] = j;
-        count++;
-      }
-    }
-  }
-  if (count > 0) {
-    int r = rand() % count;
-    board[empty[r][0]][empty[r][1]] = (rand() % 10 == 0) ? 4 : 2;
-  }
-}
-
-int can_move() {
-  for (int i = 0; i < SIZE; i++) {
-    for (int j = 0; j < SIZE; j++) {
-      if (board[i][j] == 0)
-        return 1;
-      if (j < SIZE - 1 && board[i][j] == board[i][j + 1])
-        return 1;
-      if (i < SIZE - 1 && board[i][j] == board[i + 1][j])
-        return 1;
-    }
-  }
-  return 0;
-}
-
-int move_left() {
-  int moved = 0;
-  for (int i = 0; i < SIZE; i++) {
-    int last_merge = -1;
-    for (int j = 1; j < SIZE; j++) {
-      if (board[i][j] != 0) {
-        int k = j;
-        while (k > 0 && board[i][k - 1] == 0) {
-          board[i][k - 1] = board[i][k];
-          board[i][k] = 0;
-          k--;
-          moved = 1;
-        }
-        if (k > 0 && board[i][k - 1] == board[i][k] && last_merge != k - 1) {
-          board[i][k - 1] *= 2;
-          score += board[i][k - 1];
-          if (board[i][k - 1] == WIN_VALUE)
-            won = 1;
-          board[i][k] = 0;
-          last_merge = k - 1;
-          moved = 1;
-        }
-      }
-    }
-  }
-  return moved;
-}
-
-void rotate() {
-  int temp[SIZE][SIZE];
-  for (int i = 0; i < SIZE; i++) {
-    for (int j = 0; j < SIZE; j++) {
-      temp[j][SIZE - 1 - i] = board[i][j];
-    }
-  }
-  memcpy(board, temp, sizeof(board));
-}
+Game game;
 
-int game_move(int dir) {
-  // 0: Left, 1: Up, 2: Right, 3: Down
-  int moved = 0;
-  for (int i = 0; i < dir; i++)
-    rotate();
-  moved = move_left();
-  for (int i = 0; i < (4 - dir) % 4; i++)
-    rotate();
-  return moved;
-}
+Hint *hint = NULL; // only with --hint
+int hint_y, hint_x;
 
 void init_colors() {
   if (has_colors()) {
@@ -119,15 +34,34 @@ void init_colors() {
   }
 }
 
-int get_color_pair(int value) {
-  int log2 = 0;
-  if (value == 0)
-    return 0;
-  while (value > 1) {
-    value >>= 1;
-    log2++;
-  }
-  return (log2 > 11) ? 11 : log2;
+int get_color_pair(int rank) { return (rank > 11) ? 11 : rank; }
+
+// Ask the hint thread about the current board, dropping its last search
+void request_hint() {
+  if (hint)
+    hint_request(hint, game.board);
+}
+
+// The panel to the right of the board; redrawn on its own while the
+// search deepens so the board is left alone
+void draw_hint() {
+  static const char *names[] = {"Left", "Down", "Right", "Up"};
+  int depth = 0;
+  int dir = hint_best(hint, &depth);
+
+  attron(A_BOLD);
+  mvprintw(hint_y, hint_x, "Hint");
+  attroff(A_BOLD);
+  if (game.game_over)
+    mvprintw(hint_y + 2, hint_x, "Move:  %-6s", "-");
+  else
+    mvprintw(hint_y + 2, hint_x, "Move:  %-6s", dir < 0 ? "..." : names[dir]);
+  if (dir < 0)
+    mvprintw(hint_y + 3, hint_x, "Depth: %-6s", "");
+  else
+    mvprintw(hint_y + 3, hint_x, "Depth: %-6d", depth);
+  mvprintw(hint_y + 4, hint_x, "Nodes: %-6.1fM", hint_nodes(hint) / 1e6);
+  refresh();
 }
 
 void draw() {
@@ -146,16 +80,17 @@ void draw() {
   attron(A_BOLD);
   mvprintw(offset_y - 2, offset_x + (board_w - 6) / 2, " 2048 ");
   attroff(A_BOLD);
-  mvprintw(offset_y - 1, offset_x, "Score: %d", score);
+  mvprintw(offset_y - 1, offset_x, "Score: %d", game.score);
 
   for (int i = 0; i < SIZE; i++) {
     for (int j = 0; j < SIZE; j++) {
       int y = offset_y + i * cell_h;
       int x = offset_x + j * cell_w;
-      int pair = get_color_pair(board[i][j]);
+      int rank = board_tile(game.board, i, j);
+      int pair = get_color_pair(rank);
 
       // Draw cell background and borders
-      if (board[i][j] != 0)
+      if (rank != 0)
         attron(COLOR_PAIR(pair));
 
       for (int r = 0; r <= cell_h; r++) {
@@ -164,7 +99,7 @@ void draw() {
             mvaddch(y + r, x + c, ACS_HLINE);
           } else if (c == 0 || c == cell_w) {
             mvaddch(y + r, x + c, ACS_VLINE);
-          } else if (board[i][j] != 0) {
+          } else if (rank != 0) {
             mvaddch(y + r, x + c, ' ');
           }
         }
@@ -175,9 +110,9 @@ void draw() {
       mvaddch(y + cell_h, x, ACS_PLUS);
       mvaddch(y + cell_h, x + cell_w, ACS_PLUS);
 
-      if (board[i][j] != 0) {
+      if (rank != 0) {
         char s[10];
-        sprintf(s, "%d", board[i][j]);
+        sprintf(s, "%d", 1 << rank);
         attron(A_BOLD);
         mvprintw(y + cell_h / 2, x + (cell_w - strlen(s)) / 2, "%s", s);
         attroff(A_BOLD);
@@ -186,11 +121,11 @@ void draw() {
     }
   }
 
-  if (won) {
+  if (game.won) {
     mvprintw(offset_y + board_h + 1, offset_x,
              "YOU REACHED 2048! Press 'c' to continue.");
   }
-  if (game_over) {
+  if (game.game_over) {
     attron(COLOR_PAIR(7) | A_BOLD);
     mvprintw(offset_y + board_h + 1, offset_x,
              "GAME OVER! Press 'r' to restart or 'q' to quit.");
@@ -200,31 +135,98 @@ void draw() {
              "Use Arrow Keys or WASD to move. 'q' to quit.");
   }
 
+  if (hint) {
+    hint_y = offset_y;
+    hint_x = offset_x + board_w + 3;
+    draw_hint();
+  }
+
   refresh();
 }
 
-int main() {
+// Time the packed moves: slide every position of some random games in
+// all four directions, then play whole games moving at random.
+void bench() {
+  board_init_tables();
+  uint64_t rng = 1;
+  Board positions[1 << 16];
+  int n = 0;
+  while (n < (1 << 16)) {
+    init_game(&game, random64(&rng));
+    while (n < (1 << 16) && !game.game_over) {
+      positions[n++] = game.board;
+      game_move(&game, random64(&rng) % 4);
+    }
+  }
+
+  long rounds = 200, moves = 0;
+  Board sink = 0;
+  clock_t start = clock();
+  for (long r = 0; r < rounds; r++) {
+    for (int i = 0; i < n; i++) {
+      for (int d = 0; d < 4; d++)
+        sink += board_move(positions[i], d, &game.score);
+    }
+    moves += 4L * n;
+  }
+  double secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+  printf("board_move: %.1f M moves/s (%ld moves, checksum %llx)\n", moves / secs / 1e6, moves,
+         (unsigned long long)sink);
+
+  long games = 0, played = 0;
+  start = clock();
+  while ((double)(clock() - start) / CLOCKS_PER_SEC < 1.0) {
+    init_game(&game, random64(&rng));
+    while (!game.game_over)
+      game_move(&game, random64(&rng) % 4);
+    played += game.moves;
+    games++;
+  }
+  secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+  printf("random play: %.0f games/s, %.1f M moves/s with spawns\n", games / secs,
+         played / secs / 1e6);
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+    bench();
+    return 0;
+  }
+  int show_hint = argc > 1 && strcmp(argv[1], "--hint") == 0;
+  if (argc > 2 || (argc > 1 && !show_hint)) {
+    fprintf(stderr, "usage: %s [--hint | --bench]\n", argv[0]);
+    return 1;
+  }
+
+  board_init_tables();
+  if (show_hint)
+    hint = hint_create();
   initscr();
   noecho();
   curs_set(FALSE);
   keypad(stdscr, TRUE);
   init_colors();
-  srand(time(NULL));
+  // getch() still returns each key as soon as it arrives; the timeout only
+  // lets the hint panel catch up while the player thinks
+  if (hint)
+    timeout(HINT_POLL_MS);
 
-  init_board();
-  add_random();
-  add_random();
+  init_game(&game, time(NULL));
+  request_hint();
 
   while (1) {
     draw();
     int ch = getch();
+    while (hint && ch == ERR) {
+      draw_hint();
+      ch = getch();
+    }
 
     if (ch == 'q' || ch == 'Q')
       break;
-    if (game_over && (ch == 'r' || ch == 'R')) {
-      init_board();
-      add_random();
-      add_random();
+    if (game.game_over && (ch == 'r' || ch == 'R')) {
+      init_game(&game, game.rng);
+      request_hint();
       continue;
     }
 
@@ -233,33 +235,30 @@ int main() {
     case KEY_LEFT:
     case 'a':
     case 'A':
-      moved = game_move(0);
+      moved = game_move(&game, DIR_LEFT);
       break;
     case KEY_UP:
     case 'w':
     case 'W':
-      moved = game_move(3);
+      moved = game_move(&game, DIR_UP);
       break;
     case KEY_RIGHT:
     case 'd':
     case 'D':
-      moved = game_move(2);
+      moved = game_move(&game, DIR_RIGHT);
       break;
     case KEY_DOWN:
     case 's':
     case 'S':
-      moved = game_move(1);
+      moved = game_move(&game, DIR_DOWN);
       break;
     }
 
-    if (moved) {
-      add_random();
-      if (!can_move()) {
-        game_over = 1;
-      }
-    }
+    if (moved)
+      request_hint();
   }
 
   endwin();
+  hint_destroy(hint);
   return 0;
 }
@@ -0,0 +1,213 @@
+#define _DEFAULT_SOURCE
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "snake.h"
+#include "bot.h"
+
+/*
+ * Headless batch runner.
+ *
+ * Plays many seeded games without a terminal, spread over worker threads,
+ * and reports throughput, memory per game and the score distribution.
+ * Game i is seeded with seed + i and its moves come only from that seed,
+ * so the results and the digest printed at the end are the same for any
+ * number of threads: a changed digest means a logic change altered play.
+ *
+ *   ./snake_batch [--games N] [--threads N] [--size WxH] [--seed N]
+ *                 [--ticks N] [--player bot|random]
+ */
+
+typedef struct {
+    int score;
+    int length;
+    long ticks;
+    int outcome;        /* OUTCOME_* */
+} Result;
+
+enum { OUTCOME_FULL, OUTCOME_DIED, OUTCOME_CAPPED };
+
+static int games = 1000;
+static int width = 40, height = 24;
+static uint64_t seed = 1;
+static long max_ticks = 100000;
+static int random_player = 0;
+
+static Result *results;
+static int next_game = 0;       /* first game no worker has taken yet */
+static pthread_mutex_t next_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* splitmix64, same as the game's own randomizer */
+static uint64_t random64(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/* The random player turns on about one tick in four, from a stream of
+   its own so it does not disturb where the food goes. */
+static void random_move(SnakeGame *g, uint64_t *state) {
+    static const int DX[4] = { 1, -1, 0, 0 }, DY[4] = { 0, 0, 1, -1 };
+    uint64_t r = random64(state);
+    if (r % 4 == 0) {
+        int d = (r >> 8) % 4;
+        queue_move(g, DX[d], DY[d]);
+    }
+}
+
+/* Each worker keeps one game and one bot and resets them per game, so
+   memory stays put however many games it plays. */
+static void *worker(void *arg) {
+    (void)arg;
+    SnakeGame g;
+    SnakeBot b;
+    init_game(&g, width, height, seed);
+    memset(&b, 0, sizeof(b));
+
+    while (1) {
+        pthread_mutex_lock(&next_lock);
+        int i = next_game++;
+        pthread_mutex_unlock(&next_lock);
+        if (i >= games) break;
+
+        reset_game(&g, seed + i);
+        uint64_t player = ~(seed + i);
+        if (!random_player) bot_reset(&b, &g);
+        while (!g.game_over && g.ticks < max_ticks && g.snake.length < width * height) {
+            if (random_player) random_move(&g, &player);
+            else bot_move(&b, &g);
+            process_queue(&g);
+            logic(&g);
+        }
+
+        Result *r = &results[i];
+        r->score = g.score;
+        r->length = g.snake.length;
+        r->ticks = g.ticks;
+        r->outcome = g.snake.length == width * height ? OUTCOME_FULL :
+                     g.game_over ? OUTCOME_DIED : OUTCOME_CAPPED;
+    }
+
+    free_game(&g);
+    bot_free(&b);
+    return NULL;
+}
+
+static int by_score(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+/* FNV-1a over every game's result, in game order */
+static uint64_t digest() {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < games; i++) {
+        long fields[4] = { results[i].score, results[i].length, results[i].ticks, results[i].outcome };
+        const unsigned char *p = (const unsigned char *)fields;
+        for (size_t k = 0; k < sizeof(fields); k++) {
+            h = (h ^ p[k]) * 0x100000001b3ULL;
+        }
+    }
+    return h;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [--games N] [--threads N] [--size WxH] [--seed N]\n"
+                    "       %*s [--ticks N] [--player bot|random]\n", prog, (int)strlen(prog), "");
+    fprintf(stderr, "  --games N         games to play (default 1000)\n");
+    fprintf(stderr, "  --threads N       worker threads (default: one per CPU)\n");
+    fprintf(stderr, "  --size WxH        board in cells, at least %dx%d (default 40x24)\n", MIN_WIDTH, MIN_HEIGHT);
+    fprintf(stderr, "  --seed N          game i is seeded with N + i (default 1)\n");
+    fprintf(stderr, "  --ticks N         end each game after N ticks (default 100000)\n");
+    fprintf(stderr, "  --player P        autopilot or random turns (default bot)\n");
+}
+
+int main(int argc, char **argv) {
+    int threads = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            games = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &width, &height) != 2) width = 0;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            max_ticks = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--player") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "random") == 0) random_player = 1;
+            else if (strcmp(argv[i], "bot") != 0) games = 0;
+        } else {
+            games = 0;
+        }
+    }
+    if (games < 1 || width < MIN_WIDTH || height < MIN_HEIGHT || max_ticks < 1 || threads < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (threads == 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    if (threads > games) threads = games;
+
+    results = calloc(games, sizeof(Result));
+    pthread_t *workers = malloc(sizeof(pthread_t) * threads);
+    printf("%d games on %dx%d, %s, up to %ld ticks each, %d threads\n", games, width, height,
+           random_player ? "random turns" : "autopilot", max_ticks, threads);
+
+    double start = now_seconds();
+    for (int t = 0; t < threads; t++) pthread_create(&workers[t], NULL, worker, NULL);
+    for (int t = 0; t < threads; t++) pthread_join(workers[t], NULL);
+    double secs = now_seconds() - start;
+
+    /* Memory of one game and its bot, measured on a fresh pair */
+    SnakeGame g;
+    SnakeBot b;
+    init_game(&g, width, height, seed);
+    memset(&b, 0, sizeof(b));
+    size_t memory = game_memory(&g);
+    if (!random_player) {
+        bot_reset(&b, &g);
+        memory += bot_memory(&b);
+    }
+    free_game(&g);
+    bot_free(&b);
+
+    long ticks = 0;
+    int outcomes[3] = { 0, 0, 0 };
+    int *scores = malloc(sizeof(int) * games);
+    double mean = 0;
+    for (int i = 0; i < games; i++) {
+        ticks += results[i].ticks;
+        outcomes[results[i].outcome]++;
+        scores[i] = results[i].score;
+        mean += results[i].score;
+    }
+    mean /= games;
+    qsort(scores, games, sizeof(int), by_score);
+
+    printf("wall %.3f s, %ld ticks, %.0f ticks/s (%.0f per thread), %.1f games/s\n",
+           secs, ticks, ticks / secs, ticks / secs / threads, games / secs);
+    printf("memory per game: %zu bytes (%.1f per cell)\n", memory, (double)memory / (width * height));
+    printf("score mean %.1f  min %d  p10 %d  p50 %d  p90 %d  max %d\n", mean, scores[0],
+           scores[games / 10], scores[games / 2], scores[games * 9 / 10], scores[games - 1]);
+    printf("board full %d, died %d, tick cap %d\n",
+           outcomes[OUTCOME_FULL], outcomes[OUTCOME_DIED], outcomes[OUTCOME_CAPPED]);
+    printf("digest %016llx\n", (unsigned long long)digest());
+
+    free(scores);
+    free(workers);
+    free(results);
+    return 0;
+}
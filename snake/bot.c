@@ -0,0 +1,221 @@
+#define _DEFAULT_SOURCE
+#include "bot.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* A cycle through every cell of a width x height board with an even
+   number of rows: along row 0, snake through the other rows between
+   columns 1 and width - 1, and return up column 0. */
+Point cycle_cell(int k, int width, int height) {
+    Point p;
+    if (k < width) {
+        p.x = k;
+        p.y = 0;
+        return p;
+    }
+    k -= width;
+    int rows = height - 1, inner = width - 1;
+    if (k < rows * inner) {
+        p.y = 1 + k / inner;
+        p.x = p.y % 2 ? width - 1 - k % inner : 1 + k % inner;
+        return p;
+    }
+    p.x = 0;
+    p.y = height - 1 - (k - rows * inner);
+    return p;
+}
+
+/* Whether the body, read from the tail, visits the cycle in order. */
+static int body_on_cycle(const SnakeBot *b, const SnakeGame *g) {
+    int cells = g->width * g->height;
+    Point tail = snake_segment(g, g->snake.length - 1);
+    int base = b->cycle_order[tail.y * g->width + tail.x], prev = 0;
+    for (int i = g->snake.length - 2; i >= 0; i--) {
+        Point p = snake_segment(g, i);
+        int r = (b->cycle_order[p.y * g->width + p.x] - base + cells) % cells;
+        if (r <= prev) return 0;
+        prev = r;
+    }
+    return 1;
+}
+
+/* Lay a Hamiltonian cycle over the board, running whichever way the
+   starting body already follows it. */
+void bot_reset(SnakeBot *b, const SnakeGame *g) {
+    int cells = g->width * g->height;
+    if (b->cells != cells) {
+        bot_free(b);
+        b->cycle_order = malloc(sizeof(int) * cells);
+        b->field = malloc(sizeof(int) * cells);
+        b->bfs_queue = malloc(sizeof(int) * cells);
+        b->cells = cells;
+    }
+
+    b->have_cycle = 1;
+    if (g->height % 2 == 0) {
+        for (int k = 0; k < cells; k++) {
+            Point p = cycle_cell(k, g->width, g->height);
+            b->cycle_order[p.y * g->width + p.x] = k;
+        }
+    } else if (g->width % 2 == 0) {
+        /* The same cycle on the board turned on its side */
+        for (int k = 0; k < cells; k++) {
+            Point p = cycle_cell(k, g->height, g->width);
+            b->cycle_order[p.x * g->width + p.y] = k;
+        }
+    } else {
+        b->have_cycle = 0;
+    }
+    if (b->have_cycle && !body_on_cycle(b, g)) {
+        for (int i = 0; i < cells; i++) {
+            b->cycle_order[i] = cells - 1 - b->cycle_order[i];
+        }
+        b->have_cycle = body_on_cycle(b, g);
+    }
+
+    b->field_stale = 1;
+    b->field_ready = 0;
+    b->ticks = b->ns = b->max_ns = b->fields = 0;
+}
+
+void bot_free(SnakeBot *b) {
+    free(b->cycle_order);
+    free(b->field);
+    free(b->bfs_queue);
+    memset(b, 0, sizeof(*b));
+}
+
+size_t bot_memory(const SnakeBot *b) {
+    return sizeof(*b) + (size_t)b->cells * 3 * sizeof(int);
+}
+
+/* Distance from every cell to the nearest food, stepping around the body
+   and across the wrapping edges; -1 where no food can be reached. The
+   breadth-first search is started here and run by grow_field() a slice
+   at a time, so no single tick pays for a whole large board. */
+static void start_field(SnakeBot *b, const SnakeGame *g) {
+    memset(b->field, 0xff, sizeof(int) * g->width * g->height);   /* all -1 */
+    b->bfs_head = b->bfs_tail = 0;
+    for (int i = 0; i < FOOD_COUNT; i++) {
+        if (g->food[i].x < 0) continue;
+        int cell = g->food[i].y * g->width + g->food[i].x;
+        b->field[cell] = 0;
+        b->bfs_queue[b->bfs_tail++] = cell;
+    }
+    b->field_length = g->snake.length;
+    b->field_stale = 0;
+    b->field_ready = 0;
+    b->fields++;
+}
+
+/* Visit up to `budget` more cells of the search. */
+static void grow_field(SnakeBot *b, const SnakeGame *g, int budget) {
+    int width = g->width, cells = g->width * g->height;
+    int *field = b->field, *queue = b->bfs_queue;
+    while (b->bfs_head < b->bfs_tail && budget-- > 0) {
+        int cell = queue[b->bfs_head++];
+        int x = cell % width;
+        int next[4] = {
+            x == width - 1 ? cell - x : cell + 1,
+            x == 0 ? cell + width - 1 : cell - 1,
+            cell + width < cells ? cell + width : x,
+            cell >= width ? cell - width : cells - width + x,
+        };
+        int dist = field[cell] + 1;
+        for (int d = 0; d < 4; d++) {
+            if (field[next[d]] < 0 && g->grid[next[d]] != CELL_BODY) {
+                field[next[d]] = dist;
+                queue[b->bfs_tail++] = next[d];
+            }
+        }
+    }
+    b->field_ready = b->bfs_head == b->bfs_tail;
+}
+
+static long get_current_time_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+/* The snake heads down the distance field, but only onto cells ahead of
+   its head and behind its tail along the cycle. The body then always
+   lies on the cycle in order, so the way ahead to the tail stays clear.
+   It never skips past the next food along the cycle, or it would have to
+   go all the way round to come back for it.
+
+   Cells skipped by a shortcut stay empty behind the head until the tail
+   gets past them, and if the snake eats its way up to the tail first it
+   is trapped. So shortcuts stop while the snake, those cells and room
+   for the food together still fill less than half the board; from there
+   on it follows the cycle exactly. Without a cycle (both sides odd) it
+   is plain greedy.
+
+   The field is only rebuilt when food moves or the snake grows, or when
+   the head ends up next to cells the body took after the field was
+   built. Until a rebuild finishes the snake keeps to the cycle. */
+void bot_move(SnakeBot *b, SnakeGame *g) {
+    static const int DX[4] = { 1, -1, 0, 0 }, DY[4] = { 0, 0, 1, -1 };
+    long start = get_current_time_ns();
+
+    if (b->field_stale || g->food_spawned >= 0 || g->snake.length != b->field_length) {
+        start_field(b, g);
+    }
+    if (!b->field_ready) grow_field(b, g, FIELD_BUDGET);
+
+    int width = g->width, height = g->height, cells = width * height;
+    Point head = snake_segment(g, 0);
+    Point tail = snake_segment(g, g->snake.length - 1);
+    int head_pos = 0, tail_ahead = 0, food_ahead = 0, skipped = 0;
+    if (b->have_cycle) {
+        head_pos = b->cycle_order[head.y * width + head.x];
+        tail_ahead = (b->cycle_order[tail.y * width + tail.x] - head_pos + cells) % cells;
+        skipped = cells - g->snake.length - (tail_ahead - 1);
+
+        /* Never cut past the next food along the cycle */
+        food_ahead = cells;
+        for (int i = 0; i < FOOD_COUNT; i++) {
+            if (g->food[i].x < 0) continue;
+            int ahead = (b->cycle_order[g->food[i].y * width + g->food[i].x] - head_pos + cells) % cells;
+            if (ahead < food_ahead) food_ahead = ahead;
+        }
+    }
+
+    Point neck = snake_segment(g, 1);
+    int best = -1, best_dist = -1, best_ahead = 0, body_dist = -1;
+    for (int d = 0; d < 4; d++) {
+        int x = (head.x + DX[d] + width) % width;
+        int y = (head.y + DY[d] + height) % height;
+        int cell = y * width + x;
+        if (g->grid[cell] == CELL_BODY) {
+            /* Body laid since the field was built, other than where the
+               head just came from, may be cutting across its paths */
+            if (b->field_ready && b->field[cell] >= 0 && (x != neck.x || y != neck.y) &&
+                (body_dist < 0 || b->field[cell] < body_dist)) body_dist = b->field[cell];
+            continue;
+        }
+        int ahead = 0;
+        if (b->have_cycle) {
+            ahead = (b->cycle_order[cell] - head_pos + cells) % cells;
+            if (ahead == 0 || ahead >= tail_ahead) continue;
+            if (ahead != 1 && (ahead > food_ahead ||
+                g->snake.length + skipped + ahead - 1 + FOOD_COUNT >= cells / 2)) continue;
+        }
+        /* Nearest food first, then the smallest step along the cycle */
+        int dist = b->field_ready && b->field[cell] >= 0 ? b->field[cell] : cells;
+        if (best < 0 || dist < best_dist || (dist == best_dist && ahead < best_ahead)) {
+            best = d;
+            best_dist = dist;
+            best_ahead = ahead;
+        }
+    }
+    if (best >= 0) queue_move(g, DX[best], DY[best]);
+    if (body_dist >= 0 && (best < 0 || body_dist < best_dist)) b->field_stale = 1;
+
+    long elapsed = get_current_time_ns() - start;
+    b->ticks++;
+    b->ns += elapsed;
+    if (elapsed > b->max_ns) b->max_ns = elapsed;
+}
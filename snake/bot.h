@@ -0,0 +1,48 @@
+#ifndef BOT_H
+#define BOT_H
+
+/*
+ * Snake autopilot.
+ *
+ * Plays a SnakeGame through queue_move(), heading for the nearest food
+ * along a breadth-first distance field while keeping the body in order
+ * on a Hamiltonian cycle, so it never boxes itself in. The field is
+ * cached between ticks and rebuilt a slice at a time, which bounds the
+ * work of any single decision.
+ */
+
+#include <stddef.h>
+
+#include "snake.h"
+
+#define FIELD_BUDGET 16384  /* cells the BFS visits per tick */
+
+typedef struct {
+    int cells;          /* board cells the arrays below were allocated for */
+    int *cycle_order;   /* each cell's position on a Hamiltonian cycle */
+    int have_cycle;     /* cycle_order is usable for this game */
+    int *field;         /* steps to the nearest food, -1 if unreachable */
+    int *bfs_queue;
+    int bfs_head, bfs_tail;
+    int field_stale;
+    int field_ready;    /* the BFS filling `field` has finished */
+    int field_length;   /* snake length when the field was built */
+
+    /* Statistics since bot_reset() */
+    long ticks, ns, max_ns, fields;
+} SnakeBot;
+
+/* Prepare `b` for the game just started in `g`. Allocates on first use
+   or when the board size changes; release with bot_free(). */
+void bot_reset(SnakeBot *b, const SnakeGame *g);
+void bot_free(SnakeBot *b);
+size_t bot_memory(const SnakeBot *b);
+
+/* Queue the next move for `g`. Call once per tick before process_queue(). */
+void bot_move(SnakeBot *b, SnakeGame *g);
+
+/* Cell k of the cycle the bot uses on a width x height board with an
+   even number of rows. */
+Point cycle_cell(int k, int width, int height);
+
+#endif
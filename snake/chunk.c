@@ -0,0 +1,112 @@
+#include "chunk.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_SLOTS 64
+
+static unsigned slot_of(const ChunkMap *m, int cx, int cy) {
+    uint64_t key = (uint64_t)(uint32_t)cy << 32 | (uint32_t)cx;
+    key *= 0x9E3779B97F4A7C15ULL;
+    return (unsigned)(key >> 32) & (m->capacity - 1);
+}
+
+void chunk_map_init(ChunkMap *m) {
+    m->capacity = INITIAL_SLOTS;
+    m->slots = calloc(m->capacity, sizeof(Chunk *));
+    m->count = 0;
+    m->last = NULL;
+}
+
+void chunk_map_clear(ChunkMap *m) {
+    for (int i = 0; i < m->capacity; i++) {
+        free(m->slots[i]);
+        m->slots[i] = NULL;
+    }
+    m->count = 0;
+    m->last = NULL;
+}
+
+void chunk_map_free(ChunkMap *m) {
+    if (m->slots) chunk_map_clear(m);
+    free(m->slots);
+    memset(m, 0, sizeof(*m));
+}
+
+size_t chunk_map_memory(const ChunkMap *m) {
+    return (size_t)m->capacity * sizeof(Chunk *) + (size_t)m->count * sizeof(Chunk);
+}
+
+Chunk *chunk_find(ChunkMap *m, int cx, int cy) {
+    if (m->last && m->last->cx == cx && m->last->cy == cy) return m->last;
+    for (unsigned i = slot_of(m, cx, cy);; i = (i + 1) & (m->capacity - 1)) {
+        Chunk *c = m->slots[i];
+        if (!c) return NULL;
+        if (c->cx == cx && c->cy == cy) return m->last = c;
+    }
+}
+
+/* Place `c` in the first free slot of its probe sequence. */
+static void insert_chunk(ChunkMap *m, Chunk *c) {
+    unsigned i = slot_of(m, c->cx, c->cy);
+    while (m->slots[i]) i = (i + 1) & (m->capacity - 1);
+    m->slots[i] = c;
+}
+
+static Chunk *add_chunk(ChunkMap *m, int cx, int cy) {
+    /* Keep the table at most half full */
+    if ((m->count + 1) * 2 > m->capacity) {
+        Chunk **old = m->slots;
+        int old_capacity = m->capacity;
+        m->capacity *= 2;
+        m->slots = calloc(m->capacity, sizeof(Chunk *));
+        for (int i = 0; i < old_capacity; i++) {
+            if (old[i]) insert_chunk(m, old[i]);
+        }
+        free(old);
+    }
+    Chunk *c = calloc(1, sizeof(Chunk));
+    c->cx = cx;
+    c->cy = cy;
+    insert_chunk(m, c);
+    m->count++;
+    return m->last = c;
+}
+
+/* Free `c` and close the gap it leaves in its probe sequence by moving
+   later entries back, so lookups never need tombstones. */
+static void remove_chunk(ChunkMap *m, Chunk *c) {
+    unsigned mask = m->capacity - 1, i = slot_of(m, c->cx, c->cy);
+    while (m->slots[i] != c) i = (i + 1) & mask;
+    for (unsigned j = (i + 1) & mask; m->slots[j]; j = (j + 1) & mask) {
+        unsigned home = slot_of(m, m->slots[j]->cx, m->slots[j]->cy);
+        /* Entry j may move to i only if i lies between its home and j */
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            m->slots[i] = m->slots[j];
+            i = j;
+        }
+    }
+    m->slots[i] = NULL;
+    if (m->last == c) m->last = NULL;
+    free(c);
+    m->count--;
+}
+
+unsigned char chunk_get(ChunkMap *m, int x, int y) {
+    Chunk *c = chunk_find(m, x >> CHUNK_SHIFT, y >> CHUNK_SHIFT);
+    return c ? c->cells[(y & CHUNK_MASK) * CHUNK_SIZE + (x & CHUNK_MASK)] : 0;
+}
+
+void chunk_set(ChunkMap *m, int x, int y, unsigned char value) {
+    Chunk *c = chunk_find(m, x >> CHUNK_SHIFT, y >> CHUNK_SHIFT);
+    if (!c) {
+        if (value == 0) return;
+        c = add_chunk(m, x >> CHUNK_SHIFT, y >> CHUNK_SHIFT);
+    }
+    unsigned char *cell = &c->cells[(y & CHUNK_MASK) * CHUNK_SIZE + (x & CHUNK_MASK)];
+    if (*cell == 0 && value != 0) c->used++;
+    else if (*cell != 0 && value == 0) c->used--;
+    *cell = value;
+    if (c->used == 0) remove_chunk(m, c);
+}
@@ -0,0 +1,47 @@
+#ifndef CHUNK_H
+#define CHUNK_H
+
+/*
+ * Sparse occupancy grid for boards far larger than memory.
+ *
+ * The board is cut into CHUNK_SIZE x CHUNK_SIZE squares of one byte per
+ * cell. A chunk is allocated the first time a cell in it is written with
+ * something other than 0 and freed again when its last non-zero cell is
+ * cleared, so memory follows what is on the board rather than its area.
+ * Chunks are found through an open-addressing hash table on their
+ * coordinates.
+ */
+
+#include <stddef.h>
+
+#define CHUNK_SHIFT 6
+#define CHUNK_SIZE (1 << CHUNK_SHIFT)   /* cells along each side */
+#define CHUNK_MASK (CHUNK_SIZE - 1)
+
+typedef struct {
+    int cx, cy;         /* chunk coordinates: cell x >> CHUNK_SHIFT, ... */
+    int used;           /* non-zero cells */
+    unsigned char cells[CHUNK_SIZE * CHUNK_SIZE];   /* row-major */
+} Chunk;
+
+typedef struct {
+    Chunk **slots;      /* linear probing, NULL where empty */
+    int capacity;       /* slots, a power of two */
+    int count;          /* chunks allocated */
+    Chunk *last;        /* the chunk found last, checked first */
+} ChunkMap;
+
+void chunk_map_init(ChunkMap *m);
+void chunk_map_free(ChunkMap *m);
+/* Free every chunk, keeping the table. */
+void chunk_map_clear(ChunkMap *m);
+/* Bytes held by the table and its chunks. */
+size_t chunk_map_memory(const ChunkMap *m);
+
+/* The chunk at chunk coordinates (cx, cy), or NULL if it is all zero. */
+Chunk *chunk_find(ChunkMap *m, int cx, int cy);
+
+unsigned char chunk_get(ChunkMap *m, int x, int y);
+void chunk_set(ChunkMap *m, int x, int y, unsigned char value);
+
+#endif
@@ -1,106 +1,203 @@
 #define _DEFAULT_SOURCE
 #include <ncurses.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 #include <sys/time.h>
 
+#include "snake.h"
+#include "bot.h"
+#include "world.h"
+
 /* Constants */
 #define GAME_DELAY 69000 /* 60000 * 1.15 = 69000 (15% slower) */
-#define FOOD_COUNT 10
-#define QUEUE_SIZE 3
-
-/* Structs */
-typedef struct {
-    int x; /* Logical X coordinate */
-    int y; /* Logical Y coordinate */
-} Point;
-
-typedef struct {
-    Point *body;
-    int length;
-    int dx;
-    int dy;
-} Snake;
+
+enum { BENCH_NONE, BENCH_TICKS, BENCH_BOT, BENCH_ARENA, BENCH_WORLD };
 
 /* Global Variables */
-int logic_width, logic_height;
-int score = 0;
-int game_over = 0;
-Point food[FOOD_COUNT];
-Snake snake;
-
-/* Input Queue */
-int dir_queue[QUEUE_SIZE];
-int queue_head = 0;
-int queue_tail = 0;
-int queue_count = 0;
+SnakeGame game;
+SnakeBot bot;
+int autopilot = 0;
+World world;
+int world_mode = 0;
+double tick_us = 0;     /* recent world_tick() time, smoothed */
+int full_redraw = 1;    /* repaint everything on the next draw() */
+int score_width = 0;    /* columns taken by the score text on screen */
+
+/* Camera: the board cell at the top-left of the screen and how many cells
+   fit on it. A dense board is the screen; an arena or a world of many
+   snakes scrolls under it. */
+int board_w, board_h;
+int cam_x = 0, cam_y = 0;
+int view_w, view_h;
 
 /* Function Prototypes */
 void init_ncurses();
-void reset_game();
-void queue_move(int dx, int dy);
-void process_queue();
-void logic();
+void init_colors();
 void draw();
+void draw_all();
 void cleanup();
-int show_game_over();
+int show_game_over(int score);
 long get_current_time_us();
+void bench(int width, int height);
+void bench_bot(int width, int height, long max_ticks);
+void bench_arena(int width, int height);
+int play_world(int snakes, int width, int height, long game_delay, uint64_t seed, int threads);
+void bench_world();
+
+int main(int argc, char **argv) {
+    long game_delay = GAME_DELAY;
+    uint64_t seed = (uint64_t)time(NULL);
+    int bench_mode = BENCH_NONE, arena = 0, snakes = 0, threads = 0, width = 0, height = 0, bad = 0;
+    for (int i = 1; i < argc && !bad; i++) {
+        int sized = 0;  /* the flag may be followed by a WxH board size */
+        if (strcmp(argv[i], "--bot") == 0) {
+            autopilot = 1;
+        } else if (strcmp(argv[i], "--delay") == 0 && i + 1 < argc) {
+            game_delay = atol(argv[++i]);
+            bad = game_delay <= 0;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+            bad = threads < 0;
+        } else if (strcmp(argv[i], "--bench-world") == 0) {
+            bench_mode = BENCH_WORLD;
+        } else if (strcmp(argv[i], "--arena") == 0) {
+            arena = sized = 1;
+        } else if (strcmp(argv[i], "--snakes") == 0 && i + 1 < argc) {
+            snakes = atoi(argv[++i]);
+            sized = 1;
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            bench_mode = BENCH_TICKS;
+            sized = 1;
+        } else if (strcmp(argv[i], "--bench-bot") == 0) {
+            bench_mode = BENCH_BOT;
+            sized = 1;
+        } else if (strcmp(argv[i], "--bench-arena") == 0) {
+            bench_mode = BENCH_ARENA;
+            sized = 1;
+        } else {
+            bad = 1;
+        }
+        if (sized && i + 1 < argc && argv[i + 1][0] != '-') {
+            bad = sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width < MIN_WIDTH || height < MIN_HEIGHT;
+        }
+    }
+    if (bench_mode == BENCH_TICKS && width && height % 2) bad = 1;
+    if (arena && autopilot) bad = 1;
+    if (snakes && (snakes < 1 || snakes > WORLD_MAX_SNAKES || arena || autopilot)) bad = 1;
+    if (snakes && (long)width * height > WORLD_MAX_CELLS) bad = 1;
+    if (bad) {
+        fprintf(stderr, "usage: %s [--bot] [--delay US] [--seed N]\n"
+                        "       %s --arena [WxH] [--delay US] [--seed N]\n"
+                        "       %s --snakes N [WxH] [--threads N] [--delay US] [--seed N]\n"
+                        "       %s --bench [WxH]       (H even)\n"
+                        "       %s --bench-bot [WxH]\n"
+                        "       %s --bench-arena [WxH]\n"
+                        "       %s --bench-world\n",
+                argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+        return 1;
+    }
+    if (bench_mode == BENCH_TICKS) {
+        bench(width ? width : 200, width ? height : 60);
+        return 0;
+    }
+    if (bench_mode == BENCH_BOT) {
+        bench_bot(width ? width : 500, width ? height : 200, 2000000);
+        return 0;
+    }
+    if (bench_mode == BENCH_ARENA) {
+        bench_arena(width ? width : 100000, width ? height : 100000);
+        return 0;
+    }
+    if (bench_mode == BENCH_WORLD) {
+        bench_world();
+        return 0;
+    }
 
-int main() {
     init_ncurses();
 
+    if (snakes) {
+        int ok = play_world(snakes, width, height, game_delay, seed, threads);
+        cleanup();
+        if (!ok) fprintf(stderr, "not enough memory for a world of %d snakes\n", snakes);
+        return !ok;
+    }
+
+    /* Screen dimensions: the world is the terminal, two columns per cell */
+    int term_x, term_y;
+    getmaxyx(stdscr, term_y, term_x);
+    if (arena) {
+        init_arena(&game, width ? width : 100000, width ? height : 100000, seed);
+    } else {
+        init_game(&game, term_x / 2 < MIN_WIDTH ? MIN_WIDTH : term_x / 2,
+                  term_y < MIN_HEIGHT ? MIN_HEIGHT : term_y, seed);
+    }
+
     while (1) {
-        reset_game();
+        if (autopilot) bot_reset(&bot, &game);
+        full_redraw = 1;
         long last_update_time = get_current_time_us();
 
-        while (!game_over) {
+        while (!game.game_over) {
             long current_time = get_current_time_us();
 
             /* Input Polling Loop */
             int ch;
             while ((ch = getch()) != ERR) {
+                 if (autopilot && ch != 'q' && ch != 'Q' && ch != KEY_RESIZE) continue;
                  switch (ch) {
                     case KEY_LEFT:
                     case 'a':
                     case 'A':
-                        queue_move(-1, 0); 
+                        queue_move(&game, -1, 0);
                         break;
                     case KEY_RIGHT: 
                     case 'd':
                     case 'D':
-                        queue_move(1, 0); 
+                        queue_move(&game, 1, 0);
                         break;
                     case KEY_UP:    
                     case 'w':
                     case 'W':
-                        queue_move(0, -1); 
+                        queue_move(&game, 0, -1);
                         break;
                     case KEY_DOWN:  
                     case 's':
                     case 'S':
-                        queue_move(0, 1); 
+                        queue_move(&game, 0, 1);
                         break;
                     case 'q':
                     case 'Q':
-                        game_over = 1;
+                        game.game_over = 1;
+                        break;
+                    case KEY_RESIZE:
+                        full_redraw = 1;
                         break;
                 }
             }
 
-            if (current_time - last_update_time >= GAME_DELAY) {
-                process_queue();
-                logic();
+            if (current_time - last_update_time >= game_delay) {
+                if (autopilot) bot_move(&bot, &game);
+                process_queue(&game);
+                logic(&game);
                 draw();
                 last_update_time = current_time;
             }
 
-            usleep(1000); 
+            /* Sleep until the next tick, but poll input at least every ms */
+            long wait = last_update_time + game_delay - get_current_time_us();
+            if (wait > 1000) wait = 1000;
+            if (wait > 0) usleep(wait);
         }
 
-        if (!show_game_over()) {
+        if (!show_game_over(game.score)) {
             break;
         }
+        reset_game(&game, game.rng);
     }
 
     cleanup();
@@ -113,55 +210,25 @@ long get_current_time_us() {
     return (tv.tv_sec * 1000000) + tv.tv_usec;
 }
 
-void init_ncurses() {
-    initscr();
-    noecho();
-    curs_set(FALSE);
-    keypad(stdscr, TRUE);
-    nodelay(stdscr, TRUE); /* Non-blocking getch */
-    srand(time(NULL));
-
+void init_colors() {
     if (has_colors()) {
         start_color();
         init_pair(1, COLOR_BLACK, COLOR_GREEN); /* Snake body */
         init_pair(2, COLOR_BLACK, COLOR_RED);   /* Food */
+        init_pair(3, COLOR_BLACK, COLOR_BLUE);  /* Other snakes */
     }
-
-    /* Screen dimensions */
-    int term_x, term_y;
-    getmaxyx(stdscr, term_y, term_x);
-    
-    logic_width = term_x / 2;
-    logic_height = term_y;
 }
 
-void reset_game() {
-    if (snake.body) {
-        free(snake.body);
-    }
-
-    score = 0;
-    game_over = 0;
-    queue_head = 0;
-    queue_tail = 0;
-    queue_count = 0;
-
-    /* Initialize Snake */
-    snake.length = 5;
-    snake.body = malloc(sizeof(Point) * (logic_width * logic_height));
-    snake.body[0].x = logic_width / 2;
-    snake.body[0].y = logic_height / 2;
-    snake.dx = 1; /* Starting moving RIGHT */
-    snake.dy = 0;
-
-    /* Initialize Food */
-    for (int i = 0; i < FOOD_COUNT; i++) {
-        food[i].x = rand() % (logic_width - 2) + 1;
-        food[i].y = rand() % (logic_height - 2) + 1;
-    }
+void init_ncurses() {
+    initscr();
+    noecho();
+    curs_set(FALSE);
+    keypad(stdscr, TRUE);
+    nodelay(stdscr, TRUE); /* Non-blocking getch */
+    init_colors();
 }
 
-int show_game_over() {
+int show_game_over(int score) {
     nodelay(stdscr, FALSE); // Blocking input for menu
     
     int h = 10, w = 40;
@@ -192,116 +259,510 @@ int show_game_over() {
     }
 }
 
-void queue_move(int dx, int dy) {
-    if (queue_count >= QUEUE_SIZE) return;
-
-    /* Determine the "current" direction to check against (last queued or actual snake dir) */
-    int last_dx, last_dy;
-    if (queue_count > 0) {
-        int last_idx = (queue_tail - 1 + QUEUE_SIZE) % QUEUE_SIZE;
-        /* Decode the queued integer into dx/dy. 0=Left, 1=Right, 2=Up, 3=Down */
-        int val = dir_queue[last_idx];
-        if (val == 0) { last_dx = -1; last_dy = 0; }
-        else if (val == 1) { last_dx = 1; last_dy = 0; }
-        else if (val == 2) { last_dx = 0; last_dy = -1; }
-        else { last_dx = 0; last_dy = 1; }
+/* Where board cell `p` is on screen. Returns 0 if it is off screen.
+   Wraps are done in long, as arena sides may be up to INT_MAX. */
+static int to_screen(Point p, int *sy, int *sx) {
+    int dx = ((long)p.x - cam_x + board_w) % board_w;
+    int dy = ((long)p.y - cam_y + board_h) % board_h;
+    if (dx >= view_w || dy >= view_h) return 0;
+    *sy = dy;
+    *sx = dx * 2;
+    return 1;
+}
+
+/* Paint one logical cell in color pair `pair`, or blank it if 0. */
+static void paint_cell(Point p, int pair) {
+    int sy, sx;
+    if (!to_screen(p, &sy, &sx)) return;
+    if (pair && has_colors()) attron(COLOR_PAIR(pair));
+    mvprintw(sy, sx, "  ");
+    if (pair && has_colors()) attroff(COLOR_PAIR(pair));
+}
+
+/* The score text sits on top of the board in the top-left corner. */
+static int under_score(Point p) {
+    int sy, sx;
+    return to_screen(p, &sy, &sx) && sy == 0 && sx < score_width;
+}
+
+static void draw_score() {
+    char text[96];
+    if (world_mode) {
+        const WorldSnake *s = &world.snakes[0];
+        score_width = snprintf(text, sizeof(text), "Score: %-6d Length: %-5d Snakes: %5d/%-5d Tick: %6.0f us",
+                               s->score, s->length, world.alive, world.count, tick_us);
+    } else if (autopilot && bot.ticks) {
+        score_width = snprintf(text, sizeof(text), "Score: %d  Bot: %.1f us/move",
+                               game.score, bot.ns / 1000.0 / bot.ticks);
+    } else if (game.arena) {
+        /* Fixed widths, so a shorter line never leaves digits behind */
+        Point head = snake_segment(&game, 0);
+        score_width = snprintf(text, sizeof(text), "Score: %-6d At %6d,%-6d Chunks: %-5d %6zu KB",
+                               game.score, head.x, head.y, game.chunks.count,
+                               game_memory(&game) / 1024);
     } else {
-        last_dx = snake.dx;
-        last_dy = snake.dy;
+        score_width = snprintf(text, sizeof(text), "Score: %d", game.score);
     }
+    attrset(A_NORMAL);
+    mvaddstr(0, 0, text);
+}
 
-    /* Prevent 180 degree turns */
-    if (dx == -last_dx && dy == -last_dy) return;
-    /* Prevent redundant same-direction moves outputting to queue (optional but saves space) */
-    if (dx == last_dx && dy == last_dy) return;
+/* Keep `head` in the middle half of the screen: once it leaves, move
+   the camera to center it. Scrolling in jumps rather than every tick
+   keeps most ticks to the few cells draw() repaints. Returns whether
+   the camera moved. */
+static int follow(Point head) {
+    int dx = ((long)head.x - cam_x + board_w) % board_w;
+    int dy = ((long)head.y - cam_y + board_h) % board_h;
+    int moved = 0;
+    if (dx < view_w / 4 || dx >= view_w - view_w / 4) {
+        cam_x = ((long)head.x - view_w / 2 + board_w) % board_w;
+        moved = 1;
+    }
+    if (dy < view_h / 4 || dy >= view_h - view_h / 4) {
+        cam_y = ((long)head.y - view_h / 2 + board_h) % board_h;
+        moved = 1;
+    }
+    return moved;
+}
 
-    /* Encode dx/dy to simple int for queue */
-    int val = 0;
-    if (dx == -1) val = 0;
-    else if (dx == 1) val = 1;
-    else if (dy == -1) val = 2;
-    else if (dy == 1) val = 3;
+static int follow_head() {
+    return game.arena && follow(snake_segment(&game, 0));
+}
 
-    dir_queue[queue_tail] = val;
-    queue_tail = (queue_tail + 1) % QUEUE_SIZE;
-    queue_count++;
+/* Fit the view to the terminal, but no larger than the board. */
+static void fit_view() {
+    getmaxyx(stdscr, view_h, view_w);
+    view_w /= 2;
+    if (view_w > board_w) view_w = board_w;
+    if (view_h > board_h) view_h = board_h;
 }
 
-void process_queue() {
-    if (queue_count > 0) {
-        int val = dir_queue[queue_head];
-        queue_head = (queue_head + 1) % QUEUE_SIZE;
-        queue_count--;
+/* Repaint only what the last tick changed: the new head, the cell the
+   tail left and any food that appeared. The output per tick does not
+   depend on the snake's length. */
+void draw() {
+    if (full_redraw || follow_head()) {
+        draw_all();
+        return;
+    }
 
-        if (val == 0) { snake.dx = -1; snake.dy = 0; }
-        else if (val == 1) { snake.dx = 1; snake.dy = 0; }
-        else if (val == 2) { snake.dx = 0; snake.dy = -1; }
-        else if (val == 3) { snake.dx = 0; snake.dy = 1; }
+    int repaint_score = game.arena;     /* the position changes every tick */
+    if (game.tail_left) {
+        paint_cell(game.vacated, 0);
+        repaint_score |= under_score(game.vacated);
+    }
+    if (game.food_dropped) {
+        paint_cell(game.dropped, 0);
+        repaint_score |= under_score(game.dropped);
+    }
+    if (game.food_spawned >= 0) {
+        paint_cell(game.food[game.food_spawned], 2);
+        repaint_score = 1;  /* the score went up too */
     }
+    if (game.moved) {
+        Point head = snake_segment(&game, 0);
+        paint_cell(head, 1);
+        repaint_score |= under_score(head);
+    }
+    if (repaint_score) draw_score();
+
+    refresh();
 }
 
-void logic() {
-    Point next_head = {snake.body[0].x + snake.dx, snake.body[0].y + snake.dy};
+/* Paint the arena cells on screen, reading only the chunks they fall in.
+   Each step covers the screen cells up to the next chunk edge or the
+   board's wrap, whichever comes first. */
+static void draw_chunks() {
+    for (int sy = 0; sy < view_h;) {
+        int y = ((long)cam_y + sy) % game.height;
+        int rows = CHUNK_SIZE - (y & CHUNK_MASK);
+        if (rows > view_h - sy) rows = view_h - sy;
+        if (rows > game.height - y) rows = game.height - y;
+
+        for (int sx = 0; sx < view_w;) {
+            int x = ((long)cam_x + sx) % game.width;
+            int cols = CHUNK_SIZE - (x & CHUNK_MASK);
+            if (cols > view_w - sx) cols = view_w - sx;
+            if (cols > game.width - x) cols = game.width - x;
+
+            const Chunk *c = chunk_find(&game.chunks, x >> CHUNK_SHIFT, y >> CHUNK_SHIFT);
+            for (int r = 0; c && r < rows; r++) {
+                const unsigned char *row = &c->cells[((y + r) & CHUNK_MASK) * CHUNK_SIZE];
+                for (int k = 0; k < cols; k++) {
+                    unsigned char v = row[(x + k) & CHUNK_MASK];
+                    if (v == CELL_EMPTY) continue;
+                    Point p = { x + k, y + r };
+                    paint_cell(p, v == CELL_BODY ? 1 : 2);
+                }
+            }
+            sx += cols;
+        }
+        sy += rows;
+    }
+}
 
-    /* Wall Wrapping (Logical Coordinates) */
-    if (next_head.x >= logic_width) next_head.x = 0;
-    else if (next_head.x < 0) next_head.x = logic_width - 1;
-    
-    if (next_head.y >= logic_height) next_head.y = 0;
-    else if (next_head.y < 0) next_head.y = logic_height - 1;
-
-    /* Self Collision */
-    for (int i = 0; i < snake.length; i++) {
-        if (next_head.x == snake.body[i].x && next_head.y == snake.body[i].y) {
-            game_over = 1;
-            return;
+/* Repaint the whole screen, on a new game, when the terminal resizes or
+   when the camera moves. */
+void draw_all() {
+    clear();
+
+    board_w = game.width;
+    board_h = game.height;
+    if (game.arena) {
+        fit_view();
+        follow_head();
+        draw_chunks();
+    } else {
+        view_w = game.width;
+        view_h = game.height;
+
+        /* Draw Food */
+        for (int i = 0; i < FOOD_COUNT; i++) {
+            if (game.food[i].x >= 0) paint_cell(game.food[i], 2);
+        }
+
+        /* Draw Snake */
+        const Snake *s = &game.snake;
+        for (int i = 0, j = s->head; i < s->length; i++) {
+            paint_cell(s->body[j], 1);
+            if (++j == s->capacity) j = 0;
+        }
+    }
+
+    /* Draw Score */
+    draw_score();
+
+    full_redraw = 0;
+    refresh();
+}
+
+void cleanup() {
+    free_game(&game);
+    bot_free(&bot);
+    endwin();
+}
+
+/* --- Many snakes --- */
+
+/* Paint the part of the world on screen from its grid. Without a clear()
+   ncurses sends only the cells that differ from the last frame, so the
+   terminal sees about as much as the snakes in view changed. */
+static void draw_world() {
+    if (full_redraw) {
+        clear();
+        full_redraw = 0;
+    }
+    board_w = world.width;
+    board_h = world.height;
+    fit_view();
+    if (world.snakes[0].length > 0) follow(world_head(&world, 0));
+
+    for (int sy = 0; sy < view_h; sy++) {
+        const uint16_t *row = &world.grid[(cam_y + sy) % board_h * board_w];
+        for (int sx = 0; sx < view_w; sx++) {
+            Point p = { (cam_x + sx) % board_w, (cam_y + sy) % board_h };
+            uint16_t v = row[p.x];
+            paint_cell(p, v == WORLD_EMPTY ? 0 : v == WORLD_FOOD ? 2 : v == 1 ? 1 : 3);
         }
     }
+    draw_score();
+    refresh();
+}
 
-    /* Move Snake Body */
-    for (int i = snake.length; i > 0; i--) {
-        snake.body[i] = snake.body[i - 1];
+/* Play snake 0 against the rest until it dies or 'q'. Returns 0 if the
+   world could not be allocated. */
+int play_world(int snakes, int width, int height, long game_delay, uint64_t seed, int threads) {
+    /* By default leave each snake room to move */
+    if (!width) {
+        int side = 40;
+        while ((long)(side + 1) * (side + 1) <= 600L * snakes) side++;
+        width = height = side;
     }
-    snake.body[0] = next_head;
+    world_mode = 1;
 
-    /* Eat Food */
-    for (int i = 0; i < FOOD_COUNT; i++) {
-        if (next_head.x == food[i].x && next_head.y == food[i].y) {
-            score += 10;
-            snake.length++;
-            /* Spawn new food */
-            food[i].x = rand() % (logic_width - 2) + 1;
-            food[i].y = rand() % (logic_height - 2) + 1;
-            break; 
+    while (1) {
+        if (!world_init(&world, width, height, snakes, 1, seed, threads)) return 0;
+        full_redraw = 1;
+        draw_world();
+        int quit = 0;
+        long last_update_time = get_current_time_us();
+
+        while (!quit && world.snakes[0].length > 0) {
+            long current_time = get_current_time_us();
+
+            int ch;
+            while ((ch = getch()) != ERR) {
+                switch (ch) {
+                    case KEY_LEFT: case 'a': case 'A': world_steer(&world, -1, 0); break;
+                    case KEY_RIGHT: case 'd': case 'D': world_steer(&world, 1, 0); break;
+                    case KEY_UP: case 'w': case 'W': world_steer(&world, 0, -1); break;
+                    case KEY_DOWN: case 's': case 'S': world_steer(&world, 0, 1); break;
+                    case 'q': case 'Q': quit = 1; break;
+                    case KEY_RESIZE: full_redraw = 1; break;
+                }
+            }
+
+            if (current_time - last_update_time >= game_delay) {
+                long start = get_current_time_us();
+                world_tick(&world);
+                tick_us += (get_current_time_us() - start - tick_us) / 16;
+                draw_world();
+                last_update_time = current_time;
+            }
+
+            long wait = last_update_time + game_delay - get_current_time_us();
+            if (wait > 1000) wait = 1000;
+            if (wait > 0) usleep(wait);
         }
+
+        int score = world.snakes[0].score;
+        seed = world.rng;
+        world_free(&world);
+        if (!show_game_over(score)) break;
     }
+    return 1;
 }
 
-void draw() {
-    clear(); 
+/* --- Benchmark --- */
 
-    /* Draw Food */
-    if (has_colors()) attron(COLOR_PAIR(2));
+/* Lay out a snake of `length` cells along the cycle, head at cycle
+   position length - 1, with nothing else on the board. The food is
+   taken off without waiting for a cell, so none ever appears. */
+static void bench_setup(int length) {
+    reset_game(&game, 1);
+    clear_cells(&game);
     for (int i = 0; i < FOOD_COUNT; i++) {
-        mvprintw(food[i].y, food[i].x * 2, "  ");
+        game.food[i].x = game.food[i].y = -1;
     }
-    if (has_colors()) attroff(COLOR_PAIR(2));
+    game.snake.length = length;
+    for (int i = 0; i < length; i++) {
+        game.snake.body[i] = cycle_cell(length - 1 - i, game.width, game.height);
+        set_cell(&game, game.snake.body[i], CELL_BODY);
+    }
+}
 
-    /* Draw Snake */
-    if (has_colors()) attron(COLOR_PAIR(1));
-    for (int i = 0; i < snake.length; i++) {
-        mvprintw(snake.body[i].y, snake.body[i].x * 2, "  ");
+/* Steer along the cycle and tick; k is the head's cycle position. */
+static void bench_tick(int *k) {
+    int cells = game.width * game.height;
+    Point next = cycle_cell((*k + 1) % cells, game.width, game.height);
+    Point head = snake_segment(&game, 0);
+    game.snake.dx = next.x - head.x;
+    game.snake.dy = next.y - head.y;
+    logic(&game);
+    *k = (*k + 1) % cells;
+}
+
+/* Time logic() and food placement, and count the terminal bytes per
+   tick, for snakes from 5 cells up to the whole board. The snake follows
+   the cycle, so it never dies, and food is kept off the board so its
+   length stays put. The screen goes to a scratch file through a terminal
+   of the board's size, drawn both incrementally and with a full repaint
+   every tick. */
+void bench(int width, int height) {
+    init_game(&game, width, height, 1);
+    int cells = width * height;
+    int lengths[] = { 5, 50, 500, 5000, 50000, 500000, cells / 2, cells - 1 };
+    long ticks = 200000, draw_ticks = 2000, spawns = 200000;
+
+    char size[16];
+    snprintf(size, sizeof(size), "%d", width * 2);
+    setenv("COLUMNS", size, 1);
+    snprintf(size, sizeof(size), "%d", height);
+    setenv("LINES", size, 1);
+    const char *term = getenv("TERM");
+    if (!term || !*term) term = "xterm";
+    FILE *out = tmpfile(), *in = fopen("/dev/null", "r");
+    SCREEN *screen = out && in ? newterm(term, out, in) : NULL;
+    if (!screen) {
+        fprintf(stderr, "cannot open a terminal for drawing\n");
+        free_game(&game);
+        return;
     }
-    if (has_colors()) attroff(COLOR_PAIR(1));
+    init_colors();
+
+    printf("%dx%d board, %ld ticks per length (%ld drawn for TERM=%s)\n",
+           width, height, ticks, draw_ticks, term);
+    printf("  length    ns/tick  ns/spawn  bytes/tick  (full repaint)\n");
+    for (size_t n = 0; n < sizeof(lengths) / sizeof(lengths[0]); n++) {
+        int length = lengths[n];
+        if (length > cells - 1 || (n > 0 && length <= lengths[n - 1])) continue;
+
+        bench_setup(length);
+        int k = length - 1;
+        long start = get_current_time_us();
+        for (long t = 0; t < ticks && !game.game_over; t++) {
+            bench_tick(&k);
+        }
+        long elapsed = get_current_time_us() - start;
 
-    /* Draw Score */
-    attrset(A_NORMAL);
-    mvprintw(0, 0, "Score: %d", score);
+        start = get_current_time_us();
+        for (long s = 0; s < spawns; s++) {
+            spawn_food(&game, 0);
+            set_cell(&game, game.food[0], CELL_EMPTY);
+        }
+        long spawn_elapsed = get_current_time_us() - start;
+        game.food[0].x = game.food[0].y = -1;
+
+        double bytes[2];
+        for (int full = 0; full < 2; full++) {
+            bench_setup(length);
+            k = length - 1;
+            draw_all();
+            fflush(out);
+            long before = ftell(out);
+            for (long t = 0; t < draw_ticks && !game.game_over; t++) {
+                bench_tick(&k);
+                if (full) draw_all();
+                else draw();
+            }
+            fflush(out);
+            bytes[full] = (double)(ftell(out) - before) / draw_ticks;
+        }
 
-    refresh();
-}
+        printf("%8d %10.1f %9.1f %11.1f %15.1f%s\n", length, elapsed * 1000.0 / ticks,
+               spawn_elapsed * 1000.0 / spawns, bytes[0], bytes[1], game.game_over ? "  (died)" : "");
+    }
 
-void cleanup() {
-    free(snake.body);
     endwin();
+    delscreen(screen);
+    fclose(out);
+    fclose(in);
+    free_game(&game);
+}
+
+/* Let the autopilot play a seeded game headless and report how long it
+   takes to decide each move, as the board fills up. */
+void bench_bot(int width, int height, long max_ticks) {
+    int cells = width * height;
+    init_game(&game, width, height, 1);
+    bot_reset(&bot, &game);
+
+    printf("%dx%d board, autopilot %s, up to %ld ticks\n", width, height,
+           bot.have_cycle ? "on a Hamiltonian cycle" : "greedy only (no cycle)", max_ticks);
+    printf("   ticks  length  board    ns/move  max us/move  fields\n");
+    long report = 1;
+    long window_ticks = 0, window_ns = 0, window_fields = 0;
+    while (!game.game_over && game.ticks < max_ticks) {
+        bot_move(&bot, &game);
+        process_queue(&game);
+        logic(&game);
+
+        /* Report the decisions since the last line every power of two */
+        if (game.ticks == report || game.game_over || game.ticks == max_ticks) {
+            long n = bot.ticks - window_ticks;
+            printf("%8ld %7d %5.1f%% %10.1f %12.1f %7ld\n", game.ticks, game.snake.length,
+                   100.0 * game.snake.length / cells, (double)(bot.ns - window_ns) / n,
+                   bot.max_ns / 1000.0, bot.fields - window_fields);
+            window_ticks = bot.ticks;
+            window_ns = bot.ns;
+            window_fields = bot.fields;
+            bot.max_ns = 0;
+            report *= 2;
+        }
+    }
+    printf("%s after %ld ticks, score %d\n",
+           game.snake.length == cells ? "board full" : game.game_over ? "died" : "stopped",
+           game.ticks, game.score);
+
+    free_game(&game);
+    bot_free(&bot);
+}
+
+/* Steer the arena snake along a serpentine of rows `span` cells long,
+   one row apart; k is the head's position on it. */
+static void arena_tick(int *k, int span, int grow) {
+    Point head = snake_segment(&game, 0);
+    int next = *k + 1, row = next / span, col = next % span;
+    Point p = { game.width / 2 + (row % 2 ? span - 1 - col : col) - span / 2,
+                game.height / 2 + row };
+    p.x = ((long)p.x % game.width + game.width) % game.width;
+    p.y = p.y % game.height;
+    if (grow) {
+        /* Put food 0 in the way */
+        game.food[0] = p;
+        set_cell(&game, p, CELL_FOOD);
+    }
+    game.snake.dx = p.x - head.x;
+    game.snake.dy = p.y - head.y;
+    logic(&game);
+    *k = next;
+
+    /* Take off the food eating put back, so the length stays put */
+    if (game.food_spawned >= 0) {
+        set_cell(&game, game.food[game.food_spawned], CELL_EMPTY);
+        game.food[game.food_spawned].x = game.food[game.food_spawned].y = -1;
+    }
+}
+
+/* Grow a snake on an arena and report, at each length, the time per tick
+   and the chunks and bytes the game holds, while the snake keeps moving
+   so its old chunks are freed behind it. */
+void bench_arena(int width, int height) {
+    init_arena(&game, width, height, 1);
+    int span = width < 4096 ? width : 4096;
+    int lengths[] = { 5, 100, 1000, 10000, 100000, 1000000 };
+    long ticks = 200000;
+
+    printf("%dx%d arena (%.1f GB as a dense grid), %dx%d chunks, %ld ticks per length\n",
+           width, height, (double)width * height / 1e9, CHUNK_SIZE, CHUNK_SIZE, ticks);
+    printf("   length    ns/tick   chunks   chunk KB   game KB  bytes/segment\n");
+
+    /* Lay the starting body on the serpentine: it runs from its start */
+    Snake *s = &game.snake;
+    clear_cells(&game);
+    for (int i = 0; i < FOOD_COUNT; i++) game.food[i].x = game.food[i].y = -1;
+    s->head = 0;
+    for (int i = 0; i < s->length; i++) {
+        s->body[i].x = width / 2 - span / 2 + s->length - 1 - i;
+        s->body[i].y = height / 2;
+        set_cell(&game, s->body[i], CELL_BODY);
+    }
+    int k = s->length - 1;
+
+    for (size_t n = 0; n < sizeof(lengths) / sizeof(lengths[0]) && !game.game_over; n++) {
+        while (s->length < lengths[n] && !game.game_over) arena_tick(&k, span, 1);
+
+        long start = get_current_time_us();
+        for (long t = 0; t < ticks && !game.game_over; t++) arena_tick(&k, span, 0);
+        long elapsed = get_current_time_us() - start;
+
+        size_t memory = game_memory(&game);
+        printf("%9d %10.1f %8d %10zu %9zu %14.1f%s\n", s->length, elapsed * 1000.0 / ticks,
+               game.chunks.count, chunk_map_memory(&game.chunks) / 1024, memory / 1024,
+               (double)memory / s->length, game.game_over ? "  (died)" : "");
+    }
+
+    free_game(&game);
+}
+
+/* Run bot-only worlds of growing size on 1 to 8 threads and report ticks
+   per second. Each size gets the same seed, so its digest must match on
+   every thread count. */
+void bench_world() {
+    int counts[] = { 100, 200, 400, 800, 1600 };
+    int threads[] = { 1, 2, 4, 8 };
+    long ticks = 500;
+
+    printf("bot-only worlds of ~600 cells per snake, %ld ticks each, %ld CPUs online\n",
+           ticks, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("  snakes    board  threads   ticks/s   us/tick  alive  KB       digest\n");
+    for (size_t n = 0; n < sizeof(counts) / sizeof(counts[0]); n++) {
+        int side = 40;
+        while ((long)(side + 1) * (side + 1) <= 600L * counts[n]) side++;
+        for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+            if (!world_init(&world, side, side, counts[n], 0, 1, threads[t])) {
+                fprintf(stderr, "not enough memory for %d snakes\n", counts[n]);
+                return;
+            }
+            long start = get_current_time_us();
+            for (long i = 0; i < ticks; i++) world_tick(&world);
+            long elapsed = get_current_time_us() - start;
+
+            printf("%8d %4dx%-4d %8d %9.0f %9.1f %6d %4zu %016llx\n", counts[n], side, side,
+                   threads[t], ticks * 1e6 / elapsed, (double)elapsed / ticks, world.alive,
+                   world_memory(&world) / 1024, (unsigned long long)world_digest(&world));
+            world_free(&world);
+        }
+    }
 }
@@ -0,0 +1,313 @@
+#include "snake.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* --- Randomizer --- */
+
+/* splitmix64: tiny, fast and plenty for picking cells */
+uint32_t next_random(SnakeGame *g) {
+    uint64_t z = (g->rng += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+/* --- Game State --- */
+
+void init_game(SnakeGame *g, int width, int height, uint64_t seed) {
+    int cells = width * height;
+    memset(g, 0, sizeof(*g));
+    g->width = width;
+    g->height = height;
+    g->snake.body = malloc(sizeof(Point) * cells);
+    g->snake.capacity = cells;
+    g->grid = malloc(cells);
+    g->free_cells = malloc(sizeof(int) * cells);
+    g->free_pos = malloc(sizeof(int) * cells);
+    reset_game(g, seed);
+}
+
+void init_arena(SnakeGame *g, int width, int height, uint64_t seed) {
+    memset(g, 0, sizeof(*g));
+    g->width = width;
+    g->height = height;
+    g->arena = 1;
+    chunk_map_init(&g->chunks);
+    g->snake.capacity = 64;
+    g->snake.body = malloc(sizeof(Point) * g->snake.capacity);
+    reset_game(g, seed);
+}
+
+void free_game(SnakeGame *g) {
+    free(g->snake.body);
+    chunk_map_free(&g->chunks);
+    free(g->grid);
+    free(g->free_cells);
+    free(g->free_pos);
+    memset(g, 0, sizeof(*g));
+}
+
+size_t game_memory(const SnakeGame *g) {
+    if (g->arena) {
+        return sizeof(*g) + g->snake.capacity * sizeof(Point) + chunk_map_memory(&g->chunks);
+    }
+    size_t cells = (size_t)g->width * g->height;
+    return sizeof(*g) + cells * (sizeof(Point) + 1 + 2 * sizeof(int));
+}
+
+void reset_game(SnakeGame *g, uint64_t seed) {
+    clear_cells(g);
+
+    g->seed = seed;
+    g->rng = seed;
+    g->score = 0;
+    g->game_over = 0;
+    g->ticks = 0;
+    g->queue_head = 0;
+    g->queue_tail = 0;
+    g->queue_count = 0;
+    g->moved = 0;
+    g->tail_left = 0;
+    g->food_spawned = -1;
+    g->food_dropped = 0;
+
+    /* Initialize Snake: a straight line ending at the center */
+    Snake *s = &g->snake;
+    s->head = 0;
+    s->length = 5;
+    for (int i = 0; i < s->length; i++) {
+        s->body[i].x = g->width / 2 - i;
+        s->body[i].y = g->height / 2;
+        set_cell(g, s->body[i], CELL_BODY);
+    }
+    s->dx = 1; /* Starting moving RIGHT */
+    s->dy = 0;
+
+    /* Initialize Food */
+    for (int i = 0; i < FOOD_COUNT; i++) {
+        spawn_food(g, i);
+    }
+}
+
+void clear_cells(SnakeGame *g) {
+    g->food_waiting = 0;
+    if (g->arena) {
+        chunk_map_clear(&g->chunks);
+        return;
+    }
+    int cells = g->width * g->height;
+    memset(g->grid, CELL_EMPTY, cells);
+    for (int i = 0; i < cells; i++) {
+        g->free_cells[i] = i;
+        g->free_pos[i] = i;
+    }
+    g->free_count = cells;
+}
+
+void set_cell(SnakeGame *g, Point p, unsigned char value) {
+    if (g->arena) {
+        chunk_set(&g->chunks, p.x, p.y, value);
+        return;
+    }
+    int cell = p.y * g->width + p.x;
+    if (g->grid[cell] == CELL_EMPTY && value != CELL_EMPTY) {
+        /* Fill its slot with the last free cell */
+        int last = g->free_cells[--g->free_count];
+        g->free_cells[g->free_pos[cell]] = last;
+        g->free_pos[last] = g->free_pos[cell];
+    } else if (g->grid[cell] != CELL_EMPTY && value == CELL_EMPTY) {
+        g->free_cells[g->free_count] = cell;
+        g->free_pos[cell] = g->free_count++;
+    }
+    g->grid[cell] = value;
+}
+
+/* Sides of the square around the head that arena food is placed in */
+static int span_x(const SnakeGame *g) {
+    return g->width < ARENA_FOOD_SPAN ? g->width : ARENA_FOOD_SPAN;
+}
+
+static int span_y(const SnakeGame *g) {
+    return g->height < ARENA_FOOD_SPAN ? g->height : ARENA_FOOD_SPAN;
+}
+
+/* Arena food goes on an empty cell near the head, found by trying random
+   cells of the square around it; the body can crowd it out only when
+   coiled up there, and then the food waits as on a full board. */
+static int spawn_near_head(SnakeGame *g, int i) {
+    Point head = snake_segment(g, 0);
+    int w = span_x(g), h = span_y(g);
+    for (int tries = 0; tries < 64; tries++) {
+        Point p;
+        /* In long: a side may be up to INT_MAX, twice that overflows int */
+        p.x = ((long)head.x - w / 2 + (long)(next_random(g) % w) + g->width) % g->width;
+        p.y = ((long)head.y - h / 2 + (long)(next_random(g) % h) + g->height) % g->height;
+        if (get_cell(g, p) == CELL_EMPTY) {
+            g->food[i] = p;
+            set_cell(g, p, CELL_FOOD + i);
+            return 1;
+        }
+    }
+    g->food[i].x = g->food[i].y = -1;
+    g->food_waiting++;
+    return 0;
+}
+
+/* Whether arena food at `p` has fallen outside the square around the head */
+static int out_of_reach(const SnakeGame *g, Point p, Point head) {
+    int dx = abs(p.x - head.x), dy = abs(p.y - head.y);
+    if (dx > g->width - dx) dx = g->width - dx;
+    if (dy > g->height - dy) dy = g->height - dy;
+    return dx > span_x(g) / 2 || dy > span_y(g) / 2;
+}
+
+/* Place food item i on an empty cell picked uniformly at random. With
+   the board full it waits, off the board, for the next cell to free up.
+   Returns 0 in that case. */
+int spawn_food(SnakeGame *g, int i) {
+    if (g->arena) return spawn_near_head(g, i);
+    if (g->free_count == 0) {
+        g->food[i].x = g->food[i].y = -1;
+        g->food_waiting++;
+        return 0;
+    }
+    int cell = g->free_cells[next_random(g) % g->free_count];
+    g->food[i].x = cell % g->width;
+    g->food[i].y = cell / g->width;
+    set_cell(g, g->food[i], CELL_FOOD + i);
+    return 1;
+}
+
+/* --- Input --- */
+
+void queue_move(SnakeGame *g, int dx, int dy) {
+    if (g->queue_count >= QUEUE_SIZE) return;
+
+    /* Determine the "current" direction to check against (last queued or actual snake dir) */
+    int last_dx, last_dy;
+    if (g->queue_count > 0) {
+        int last_idx = (g->queue_tail - 1 + QUEUE_SIZE) % QUEUE_SIZE;
+        /* Decode the queued integer into dx/dy. 0=Left, 1=Right, 2=Up, 3=Down */
+        int val = g->dir_queue[last_idx];
+        if (val == 0) { last_dx = -1; last_dy = 0; }
+        else if (val == 1) { last_dx = 1; last_dy = 0; }
+        else if (val == 2) { last_dx = 0; last_dy = -1; }
+        else { last_dx = 0; last_dy = 1; }
+    } else {
+        last_dx = g->snake.dx;
+        last_dy = g->snake.dy;
+    }
+
+    /* Prevent 180 degree turns */
+    if (dx == -last_dx && dy == -last_dy) return;
+    /* Prevent redundant same-direction moves outputting to queue (optional but saves space) */
+    if (dx == last_dx && dy == last_dy) return;
+
+    /* Encode dx/dy to simple int for queue */
+    int val = 0;
+    if (dx == -1) val = 0;
+    else if (dx == 1) val = 1;
+    else if (dy == -1) val = 2;
+    else if (dy == 1) val = 3;
+
+    g->dir_queue[g->queue_tail] = val;
+    g->queue_tail = (g->queue_tail + 1) % QUEUE_SIZE;
+    g->queue_count++;
+}
+
+void process_queue(SnakeGame *g) {
+    if (g->queue_count > 0) {
+        int val = g->dir_queue[g->queue_head];
+        g->queue_head = (g->queue_head + 1) % QUEUE_SIZE;
+        g->queue_count--;
+
+        Snake *s = &g->snake;
+        if (val == 0) { s->dx = -1; s->dy = 0; }
+        else if (val == 1) { s->dx = 1; s->dy = 0; }
+        else if (val == 2) { s->dx = 0; s->dy = -1; }
+        else if (val == 3) { s->dx = 0; s->dy = 1; }
+    }
+}
+
+/* --- Tick --- */
+
+/* Double the body buffer, unrolling the ring so the head is at 0. */
+static void grow_body(Snake *s) {
+    Point *body = malloc(sizeof(Point) * s->capacity * 2);
+    for (int i = 0; i < s->length; i++) {
+        body[i] = s->body[(s->head + i) % s->capacity];
+    }
+    free(s->body);
+    s->body = body;
+    s->head = 0;
+    s->capacity *= 2;
+}
+
+void logic(SnakeGame *g) {
+    Snake *s = &g->snake;
+    if (s->length == s->capacity && g->arena) grow_body(s);
+    Point head = s->body[s->head];
+    Point tail = s->body[(s->head + s->length - 1) % s->capacity];
+    Point next_head = {head.x + s->dx, head.y + s->dy};
+    g->moved = 0;
+    g->tail_left = 0;
+    g->food_spawned = -1;
+    g->food_dropped = 0;
+    g->ticks++;
+
+    /* Wall Wrapping (Logical Coordinates) */
+    if (next_head.x >= g->width) next_head.x = 0;
+    else if (next_head.x < 0) next_head.x = g->width - 1;
+
+    if (next_head.y >= g->height) next_head.y = 0;
+    else if (next_head.y < 0) next_head.y = g->height - 1;
+
+    /* Self Collision: the tail has not left its cell yet */
+    unsigned char cell = get_cell(g, next_head);
+    if (cell == CELL_BODY) {
+        g->game_over = 1;
+        return;
+    }
+    int eaten = cell >= CELL_FOOD ? cell - CELL_FOOD : -1;
+    set_cell(g, next_head, CELL_BODY);
+
+    /* Move Snake Body: step the head back one slot; the old tail slot
+       simply falls outside the length unless the snake grows */
+    s->head = (s->head + s->capacity - 1) % s->capacity;
+    s->body[s->head] = next_head;
+    g->moved = 1;
+
+    /* Eat Food, or let the tail leave its cell */
+    if (eaten >= 0) {
+        g->score += 10;
+        s->length++;
+        if (spawn_food(g, eaten)) g->food_spawned = eaten;
+    } else {
+        set_cell(g, tail, CELL_EMPTY);
+        g->tail_left = 1;
+        g->vacated = tail;
+
+        /* Food left waiting on a full board takes the first free cell */
+        for (int i = 0; g->food_waiting > 0 && i < FOOD_COUNT; i++) {
+            if (g->food[i].x < 0) {
+                g->food_waiting--;
+                spawn_food(g, i);
+                g->food_spawned = i;
+                break;
+            }
+        }
+    }
+
+    /* Arena food the head has left far behind moves back near it, one
+       item per tick and only on a tick that placed no other food */
+    if (g->arena && g->food_spawned < 0) {
+        int i = g->ticks % FOOD_COUNT;
+        if (g->food[i].x >= 0 && out_of_reach(g, g->food[i], next_head)) {
+            g->dropped = g->food[i];
+            g->food_dropped = 1;
+            set_cell(g, g->food[i], CELL_EMPTY);
+            if (spawn_food(g, i)) g->food_spawned = i;
+        }
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef SNAKE_H
+#define SNAKE_H
+
+/*
+ * Headless Snake rules engine.
+ *
+ * All state lives in a SnakeGame: the board size, the body, the food, the
+ * input queue and a seeded random generator. Nothing here touches the
+ * terminal or the clock, so the same seed and the same moves always play
+ * the same game. The ncurses front end in main.c is one client, the batch
+ * runner in batch.c is another.
+ *
+ * A board is either dense, one byte per cell plus a free-cell set, or an
+ * arena far bigger than the screen whose occupancy lives in a ChunkMap.
+ * In an arena the body buffer grows with the snake and food is kept
+ * within reach of the head instead of anywhere on the board.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chunk.h"
+
+/* Constants */
+#define FOOD_COUNT 10
+#define QUEUE_SIZE 3
+#define ARENA_FOOD_SPAN 64  /* arena food lies in a square this wide around the head */
+#define MIN_WIDTH 8         /* room for the starting body left of the center */
+#define MIN_HEIGHT 4
+
+/* Occupancy grid cell values; food item i is CELL_FOOD + i */
+#define CELL_EMPTY 0
+#define CELL_BODY 1
+#define CELL_FOOD 2
+
+/* Structs */
+typedef struct {
+    int x; /* Logical X coordinate */
+    int y; /* Logical Y coordinate */
+} Point;
+
+/* The body is a ring buffer: segment i (0 = head) lives at
+   body[(head + i) % capacity], so moving and growing touch one slot. */
+typedef struct {
+    Point *body;
+    int capacity;   /* width * height, or doubled as needed in an arena */
+    int head;
+    int length;
+    int dx;
+    int dy;
+} Snake;
+
+typedef struct {
+    int width, height;  /* logical cells; the board wraps at the edges */
+    int score;
+    int game_over;
+    long ticks;
+
+    Snake snake;
+    Point food[FOOD_COUNT];
+    int food_waiting;   /* food items with no empty cell to go to (x == -1) */
+    unsigned char *grid;    /* width * height cells, row-major; dense only */
+    int arena;
+    ChunkMap chunks;        /* occupancy of an arena */
+
+    /* Empty cells as an indexed set: free_cells[0..free_count) lists them
+       in any order and free_pos[cell] is each one's slot there, so insert,
+       remove and a uniform pick are all constant time. Dense only. */
+    int *free_cells;
+    int *free_pos;
+    int free_count;
+
+    /* Input Queue */
+    int dir_queue[QUEUE_SIZE];
+    int queue_head;
+    int queue_tail;
+    int queue_count;
+
+    uint64_t seed;      /* seed of the current game */
+    uint64_t rng;
+
+    /* What the last logic() call changed, for renderers */
+    int moved;          /* the head advanced */
+    int tail_left;      /* ...and the tail left `vacated` */
+    Point vacated;
+    int food_spawned;   /* index of food placed this tick, -1 if none */
+    int food_dropped;   /* arena food left behind and taken off `dropped` */
+    Point dropped;
+} SnakeGame;
+
+/* Allocate a width x height board (at least MIN_WIDTH x MIN_HEIGHT) and
+   start a game on it. Release with free_game(). */
+void init_game(SnakeGame *g, int width, int height, uint64_t seed);
+/* The same on an arena, which may be as large as int coordinates allow. */
+void init_arena(SnakeGame *g, int width, int height, uint64_t seed);
+void free_game(SnakeGame *g);
+
+/* Start a new game on the same board, reusing its memory. */
+void reset_game(SnakeGame *g, uint64_t seed);
+
+/* Bytes held by the game, its struct included. */
+size_t game_memory(const SnakeGame *g);
+
+uint32_t next_random(SnakeGame *g);
+
+/* Empty the grid and put every cell in the free set. */
+void clear_cells(SnakeGame *g);
+/* Write a grid cell, moving it into or out of the free set. */
+void set_cell(SnakeGame *g, Point p, unsigned char value);
+static inline unsigned char get_cell(SnakeGame *g, Point p) {
+    return g->arena ? chunk_get(&g->chunks, p.x, p.y) : g->grid[p.y * g->width + p.x];
+}
+int spawn_food(SnakeGame *g, int i);
+
+/* Input: queue a turn for a coming tick, then advance one tick. */
+void queue_move(SnakeGame *g, int dx, int dy);
+void process_queue(SnakeGame *g);
+void logic(SnakeGame *g);
+
+/* Body segment i, 0 being the head. */
+static inline Point snake_segment(const SnakeGame *g, int i) {
+    return g->snake.body[(g->snake.head + i) % g->snake.capacity];
+}
+
+#endif
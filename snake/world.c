@@ -0,0 +1,394 @@
+#define _DEFAULT_SOURCE
+#include "world.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SIGHT_SIDE (2 * WORLD_SIGHT + 1)
+#define START_LENGTH 5
+
+static const int DX[4] = { 1, -1, 0, 0 }, DY[4] = { 0, 0, 1, -1 };
+
+/* splitmix64, as in the single game */
+static uint64_t random64(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static int wrap(int v, int size) {
+    v %= size;
+    return v < 0 ? v + size : v;
+}
+
+static int is_snake(uint16_t v) {
+    return v != WORLD_EMPTY && v != WORLD_FOOD;
+}
+
+/* --- Phase one: each bot picks a move --- */
+
+/* Whether another snake's head is next to (x, y), so moving there could
+   end head to head. */
+static int near_head(const World *w, int self, int x, int y) {
+    for (int d = 0; d < 4; d++) {
+        int nx = wrap(x + DX[d], w->width), ny = wrap(y + DY[d], w->height);
+        uint16_t v = w->grid[ny * w->width + nx];
+        if (!is_snake(v) || v - 1 == self) continue;
+        Point h = world_head(w, v - 1);
+        if (h.x == nx && h.y == ny) return 1;
+    }
+    return 0;
+}
+
+/* Breadth-first search over the cells within sight, starting from the
+   safe first moves, for the nearest food; the bot takes the first move
+   of the path to it. Cells next to another head are only used when there
+   is nothing else. Reads the board and writes nothing but the snake's
+   own next_dx, next_dy and rng.
+
+   The cells in sight are first copied into a small map walled in on all
+   sides, so the search itself needs no wrapping or bounds checks; it
+   marks cells it has seen by walling them too. */
+static void plan_bot(World *w, int i) {
+    enum { SIDE = SIGHT_SIDE + 2, CENTER = (WORLD_SIGHT + 1) * SIDE + WORLD_SIGHT + 1 };
+    enum { OPEN, FOOD, WALL };
+    static const int STEP[4] = { 1, -1, SIDE, -SIDE };  /* DX, DY in map cells */
+    unsigned char map[SIDE * SIDE], step[SIDE * SIDE];
+    short queue[SIDE * SIDE];
+    WorldSnake *s = &w->snakes[i];
+    Point head = world_head(w, i);
+
+    memset(map, WALL, sizeof(map));
+    for (int y = 0; y < SIGHT_SIDE; y++) {
+        const uint16_t *row = &w->grid[wrap(head.y + y - WORLD_SIGHT, w->height) * w->width];
+        unsigned char *out = &map[(y + 1) * SIDE + 1];
+        for (int x = 0, bx = wrap(head.x - WORLD_SIGHT, w->width); x < SIGHT_SIDE; x++) {
+            uint16_t v = row[bx];
+            out[x] = v == WORLD_EMPTY ? OPEN : v == WORLD_FOOD ? FOOD : WALL;
+            if (++bx == w->width) bx = 0;
+        }
+    }
+    map[CENTER] = WALL;
+
+    /* Seed the search in a random order, so ties go different ways */
+    int first = random64(&s->rng) % 4, qh = 0, qt = 0;
+    for (int risky = 0; risky < 2 && qt == 0; risky++) {
+        for (int n = 0; n < 4; n++) {
+            int d = (first + n) % 4, l = CENTER + STEP[d];
+            if (DX[d] == -s->dx && DY[d] == -s->dy) continue;
+            if (map[l] == WALL) continue;
+            int x = wrap(head.x + DX[d], w->width), y = wrap(head.y + DY[d], w->height);
+            if (near_head(w, i, x, y) != risky) continue;
+            step[l] = d;
+            queue[qt++] = l;
+        }
+    }
+    if (qt == 0) return;    /* boxed in: keep going and die */
+
+    int best = step[queue[0]];
+    for (int n = 0; n < qt; n++) {
+        if (map[queue[n]] == FOOD) {
+            best = step[queue[n]];
+            qh = qt;
+        }
+        map[queue[n]] = WALL;
+    }
+    while (qh < qt) {
+        int l = queue[qh++];
+        for (int d = 0; d < 4; d++) {
+            int nl = l + STEP[d];
+            if (map[nl] == WALL) continue;
+            step[nl] = step[l];
+            if (map[nl] == FOOD) {
+                best = step[nl];
+                qh = qt;
+                break;
+            }
+            map[nl] = WALL;
+            queue[qt++] = nl;
+        }
+    }
+    s->next_dx = DX[best];
+    s->next_dy = DY[best];
+}
+
+static void plan_range(World *w, WorldWorker *k) {
+    for (int i = k->first; i < k->last; i++) {
+        if (w->snakes[i].length == 0 || (i == 0 && w->human)) continue;
+        plan_bot(w, i);
+    }
+}
+
+static void *world_worker(void *arg) {
+    WorldWorker *k = arg;
+    World *w = k->world;
+    long done_generation = 0;
+    pthread_mutex_lock(&w->lock);
+    while (1) {
+        while (!w->quit && w->generation == done_generation) pthread_cond_wait(&w->start, &w->lock);
+        if (w->quit) break;
+        done_generation = w->generation;
+        pthread_mutex_unlock(&w->lock);
+
+        plan_range(w, k);
+
+        pthread_mutex_lock(&w->lock);
+        if (--w->pending == 0) pthread_cond_signal(&w->done);
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+/* --- Phase two: apply the moves in snake order --- */
+
+/* Lay snake i down as a straight line on empty cells somewhere random.
+   Returns 0 if no room turned up. */
+static int place_snake(World *w, int i) {
+    WorldSnake *s = &w->snakes[i];
+    for (int tries = 0; tries < 16; tries++) {
+        uint64_t r = random64(&w->rng);
+        int x = r % w->width, y = (r >> 32) % w->height, d = (r >> 20) % 4;
+        int free = 1;
+        for (int n = 0; n < START_LENGTH && free; n++) {
+            int cx = wrap(x - DX[d] * n, w->width), cy = wrap(y - DY[d] * n, w->height);
+            free = w->grid[cy * w->width + cx] == WORLD_EMPTY;
+        }
+        if (!free) continue;
+
+        s->head = 0;
+        s->length = START_LENGTH;
+        for (int n = 0; n < START_LENGTH; n++) {
+            s->body[n].x = wrap(x - DX[d] * n, w->width);
+            s->body[n].y = wrap(y - DY[d] * n, w->height);
+            w->grid[s->body[n].y * w->width + s->body[n].x] = i + 1;
+        }
+        s->dx = s->next_dx = DX[d];
+        s->dy = s->next_dy = DY[d];
+        w->alive++;
+        return 1;
+    }
+    return 0;
+}
+
+/* Take snake i off the board, leaving food on every third cell. */
+static void kill_snake(World *w, int i) {
+    WorldSnake *s = &w->snakes[i];
+    for (int n = 0; n < s->length; n++) {
+        Point p = s->body[(s->head + n) % s->capacity];
+        int food = n % 3 == 1;
+        w->grid[p.y * w->width + p.x] = food ? WORLD_FOOD : WORLD_EMPTY;
+        w->food += food;
+    }
+    s->length = 0;
+    s->respawn = i == 0 && w->human ? -1 : WORLD_RESPAWN;
+    w->alive--;
+}
+
+static void move_snake(World *w, int i, Point to) {
+    WorldSnake *s = &w->snakes[i];
+    uint16_t *cell = &w->grid[to.y * w->width + to.x];
+    int eats = *cell == WORLD_FOOD;
+    if (eats) {
+        w->food--;
+        s->score += 10;
+        if (s->length == s->capacity) {
+            /* Double the ring, unrolled so the head is at 0 */
+            Point *body = malloc(sizeof(Point) * s->capacity * 2);
+            for (int n = 0; n < s->length; n++) body[n] = s->body[(s->head + n) % s->capacity];
+            free(s->body);
+            s->body = body;
+            s->head = 0;
+            s->capacity *= 2;
+        }
+    } else {
+        Point tail = s->body[(s->head + s->length - 1) % s->capacity];
+        w->grid[tail.y * w->width + tail.x] = WORLD_EMPTY;
+    }
+    s->head = (s->head + s->capacity - 1) % s->capacity;
+    s->body[s->head] = to;
+    s->length += eats;
+    s->dx = s->next_dx;
+    s->dy = s->next_dy;
+    *cell = i + 1;
+}
+
+static int by_target(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Heads may only enter cells that were empty or food before the tick,
+   and never the same one as another head. Every rule reads the board as
+   the tick found it, so the order moves are applied in does not change
+   who lives. */
+static void resolve(World *w) {
+    int m = 0;
+    for (int i = 0; i < w->count; i++) {
+        WorldSnake *s = &w->snakes[i];
+        if (s->length == 0) continue;
+        Point h = world_head(w, i);
+        int x = wrap(h.x + s->next_dx, w->width), y = wrap(h.y + s->next_dy, w->height);
+        w->order[m++] = (uint64_t)(y * w->width + x) << 32 | (uint32_t)i;
+        s->dies = is_snake(w->grid[y * w->width + x]);
+    }
+    qsort(w->order, m, sizeof(uint64_t), by_target);
+    for (int a = 0; a < m; a++) {
+        int cell = w->order[a] >> 32;
+        if ((a > 0 && (int)(w->order[a - 1] >> 32) == cell) ||
+            (a + 1 < m && (int)(w->order[a + 1] >> 32) == cell)) {
+            w->snakes[(uint32_t)w->order[a]].dies = 1;
+        }
+    }
+
+    for (int i = 0; i < w->count; i++) {
+        if (w->snakes[i].length > 0 && w->snakes[i].dies) kill_snake(w, i);
+    }
+    for (int i = 0; i < w->count; i++) {
+        WorldSnake *s = &w->snakes[i];
+        if (s->length == 0) continue;
+        Point h = world_head(w, i);
+        Point to = { wrap(h.x + s->next_dx, w->width), wrap(h.y + s->next_dy, w->height) };
+        move_snake(w, i, to);
+    }
+
+    /* Top the food back up, giving up on a crowded board */
+    for (int tries = 4 * (w->food_target - w->food); tries > 0 && w->food < w->food_target; tries--) {
+        uint64_t r = random64(&w->rng);
+        int cell = (r >> 16) % ((uint64_t)w->width * w->height);
+        if (w->grid[cell] == WORLD_EMPTY) {
+            w->grid[cell] = WORLD_FOOD;
+            w->food++;
+        }
+    }
+
+    for (int i = 0; i < w->count; i++) {
+        WorldSnake *s = &w->snakes[i];
+        if (s->length > 0 || s->respawn < 0) continue;
+        if (--s->respawn > 0) continue;
+        if (place_snake(w, i)) s->score = 0;
+        else s->respawn = 1;
+    }
+}
+
+/* --- World --- */
+
+/* Release what world_init() allocated before the threads started */
+static void free_storage(World *w) {
+    for (int i = 0; w->snakes && i < w->count; i++) free(w->snakes[i].body);
+    free(w->snakes);
+    free(w->grid);
+    free(w->order);
+    free(w->workers);
+    memset(w, 0, sizeof(*w));
+}
+
+int world_init(World *w, int width, int height, int count, int human, uint64_t seed, int threads) {
+    memset(w, 0, sizeof(*w));
+    if ((long)width * height > WORLD_MAX_CELLS) return 0;
+    w->width = width;
+    w->height = height;
+    w->count = count;
+    w->human = human;
+    w->rng = seed;
+    w->grid = calloc((size_t)width * height, sizeof(uint16_t));
+    w->snakes = calloc(count, sizeof(WorldSnake));
+    w->order = malloc(sizeof(uint64_t) * count);
+    w->food_target = count * WORLD_FOOD_PER_SNAKE;
+
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > count) threads = count;
+    if (threads < 1) threads = 1;
+    w->threads = threads;
+    w->workers = calloc(threads, sizeof(WorldWorker));
+    if (!w->grid || !w->snakes || !w->order || !w->workers) {
+        free_storage(w);
+        return 0;
+    }
+    for (int i = 0; i < count; i++) {
+        w->snakes[i].capacity = 16;
+        w->snakes[i].body = malloc(sizeof(Point) * 16);
+        if (!w->snakes[i].body) {
+            free_storage(w);
+            return 0;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        WorldSnake *s = &w->snakes[i];
+        s->rng = seed ^ ((uint64_t)(i + 1) << 32);
+        if (!place_snake(w, i)) s->respawn = 1;
+    }
+
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->start, NULL);
+    pthread_cond_init(&w->done, NULL);
+    for (int t = 0; t < threads; t++) {
+        WorldWorker *k = &w->workers[t];
+        k->world = w;
+        k->first = (int)((long)count * t / threads);
+        k->last = (int)((long)count * (t + 1) / threads);
+        if (t > 0) pthread_create(&k->thread, NULL, world_worker, k);
+    }
+    return 1;
+}
+
+void world_free(World *w) {
+    pthread_mutex_lock(&w->lock);
+    w->quit = 1;
+    pthread_cond_broadcast(&w->start);
+    pthread_mutex_unlock(&w->lock);
+    for (int t = 1; t < w->threads; t++) pthread_join(w->workers[t].thread, NULL);
+    pthread_mutex_destroy(&w->lock);
+    pthread_cond_destroy(&w->start);
+    pthread_cond_destroy(&w->done);
+
+    free_storage(w);
+}
+
+size_t world_memory(const World *w) {
+    size_t bytes = sizeof(*w) + (size_t)w->width * w->height * sizeof(uint16_t);
+    bytes += (size_t)w->count * (sizeof(WorldSnake) + sizeof(uint64_t));
+    for (int i = 0; i < w->count; i++) bytes += w->snakes[i].capacity * sizeof(Point);
+    bytes += w->threads * sizeof(WorldWorker);
+    return bytes;
+}
+
+void world_steer(World *w, int dx, int dy) {
+    WorldSnake *s = &w->snakes[0];
+    if (!w->human || (dx == -s->dx && dy == -s->dy)) return;
+    s->next_dx = dx;
+    s->next_dy = dy;
+}
+
+void world_tick(World *w) {
+    if (w->threads > 1) {
+        pthread_mutex_lock(&w->lock);
+        w->generation++;
+        w->pending = w->threads - 1;
+        pthread_cond_broadcast(&w->start);
+        pthread_mutex_unlock(&w->lock);
+    }
+    plan_range(w, &w->workers[0]);
+    if (w->threads > 1) {
+        pthread_mutex_lock(&w->lock);
+        while (w->pending > 0) pthread_cond_wait(&w->done, &w->lock);
+        pthread_mutex_unlock(&w->lock);
+    }
+
+    resolve(w);
+    w->ticks++;
+}
+
+uint64_t world_digest(const World *w) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < w->count; i++) {
+        const WorldSnake *s = &w->snakes[i];
+        Point p = s->length ? world_head(w, i) : (Point){ -1, -1 };
+        int fields[4] = { s->length, s->score, p.x, p.y };
+        const unsigned char *b = (const unsigned char *)fields;
+        for (size_t k = 0; k < sizeof(fields); k++) h = (h ^ b[k]) * 0x100000001b3ULL;
+    }
+    return (h ^ (uint64_t)w->food) * 0x100000001b3ULL;
+}
@@ -0,0 +1,102 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+/*
+ * Many snakes on one wrapping board.
+ *
+ * Every snake is a bot except, optionally, snake 0, which follows
+ * world_steer(). All of them share one grid that records which snake, if
+ * any, holds each cell, and that grid is what every collision is judged
+ * against.
+ *
+ * A tick runs in two phases. First each bot picks its move from the board
+ * as the tick found it; the snakes are split across worker threads, and
+ * since nothing is written but each snake's own choice, the split does not
+ * matter. Then one thread applies the moves in snake order: heads that
+ * meet die together, heads that hit any body die (a tail has not left its
+ * cell yet, as in the single game), the rest move and eat. The same seed
+ * therefore plays the same world for any number of threads.
+ *
+ * Dead bots leave food where their body was and come back after a while;
+ * eaten food reappears on random empty cells.
+ */
+
+#include <limits.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "snake.h"
+
+#define WORLD_EMPTY 0
+#define WORLD_FOOD 0xffff   /* any other cell value is 1 + snake index */
+#define WORLD_MAX_SNAKES 0xfffe
+#define WORLD_SIGHT 8       /* bots look for food up to this many steps away */
+#define WORLD_FOOD_PER_SNAKE 2
+#define WORLD_RESPAWN 20    /* ticks a dead bot waits before it returns */
+#define WORLD_MAX_CELLS INT_MAX /* cells are indexed, and sorted in `order`, as int */
+
+typedef struct {
+    Point *body;        /* ring buffer as in Snake, grown as needed */
+    int capacity;
+    int head;
+    int length;         /* 0 while dead */
+    int dx, dy;
+    int next_dx, next_dy;   /* the move chosen for this tick */
+    int score;
+    int respawn;        /* ticks left until a dead bot returns */
+    int dies;           /* set while resolving a tick */
+    uint64_t rng;       /* the snake's own choices, so threads do not matter */
+} WorldSnake;
+
+/* Phase one work for one thread: a fixed range of snakes. */
+typedef struct {
+    struct World *world;
+    int first, last;
+    pthread_t thread;
+} WorldWorker;
+
+typedef struct World {
+    int width, height;
+    uint16_t *grid;     /* WORLD_EMPTY, WORLD_FOOD or 1 + snake index */
+    WorldSnake *snakes;
+    int count;
+    int alive;
+    int human;          /* 1 if snake 0 is steered by world_steer() */
+    int food, food_target;
+    long ticks;
+    uint64_t rng;       /* food and respawn placement */
+    uint64_t *order;    /* resolving scratch: target cell << 32 | snake, sorted */
+
+    /* Worker threads; worker 0 is the caller of world_tick() */
+    int threads;
+    WorldWorker *workers;
+    pthread_mutex_t lock;
+    pthread_cond_t start, done;
+    long generation;
+    int pending;
+    int quit;
+} World;
+
+/* Start `count` snakes (at most WORLD_MAX_SNAKES) on a width x height
+   board, snake 0 steered by hand if `human`. Phase one runs on `threads`
+   threads, one per online CPU if 0. Release with world_free(). Returns 0,
+   with nothing to release, if the board has more than WORLD_MAX_CELLS
+   cells or memory runs out. */
+int world_init(World *w, int width, int height, int count, int human, uint64_t seed, int threads);
+void world_free(World *w);
+size_t world_memory(const World *w);
+
+/* Turn snake 0 for the next tick, unless that would reverse it. */
+void world_steer(World *w, int dx, int dy);
+void world_tick(World *w);
+
+/* Head of snake i; only meaningful while its length is non-zero. */
+static inline Point world_head(const World *w, int i) {
+    return w->snakes[i].body[w->snakes[i].head];
+}
+
+/* FNV-1a over every snake and the food count, for comparing runs. */
+uint64_t world_digest(const World *w);
+
+#endif
@@ -0,0 +1,184 @@
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tetris.h"
+
+/*
+ * Headless throughput benchmark: plays seeded games on a virtual clock with
+ * a random rotate/shift/hard-drop policy and reports the simulation rate.
+ *
+ * With --scaling it instead times the collision, landing and line-clear
+ * kernels on board sizes from 10x20 up to 64x16000.
+ *
+ *   ./tetris_bench [seconds]
+ *   ./tetris_bench --scaling [seconds per kernel]
+ */
+
+#define ACTION_US 16000     /* virtual time between policy actions */
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Play one game to top-out; returns the number of pieces locked. */
+static int play_game(TetrisGame *g, uint64_t seed) {
+    long t = 0;
+    free_game(g);
+    init_game(g, seed, t);
+
+    while (!g->game_over) {
+        uint32_t r = next_random(g);
+        int rotations = r & 3;
+        int shift = (int)((r >> 2) % 9) - 4;
+        int dir = shift < 0 ? -1 : 1;
+
+        if ((r >> 8) % 8 == 0) hold_piece(g, t);
+        for (int i = 0; i < rotations; i++) rotate_piece(g, 1, t);
+        for (int i = 0; i != shift; i += dir) {
+            if (!move_piece(g, dir, 0, t)) break;
+        }
+        t += ACTION_US;
+        update_game(g, t);
+        if (!g->game_over) hard_drop(g, t);
+    }
+    return g->pieces;
+}
+
+/* --- Kernel scaling --- */
+
+#define PROBES 4096
+
+typedef struct {
+    int type, rot, x, y;
+} Probe;
+
+static Probe probes[PROBES];
+static int stack_rows;      /* stack height the clear kernel keeps constant */
+static volatile long sink;  /* keeps kernel results live */
+
+static RowMask holey_row(TetrisGame *g) {
+    return g->board.full & ~((RowMask)1 << (next_random(g) % g->board.width));
+}
+
+/* Fill the bottom `rows` rows, each with one hole, and aim the probes at
+   the top of that stack where real pieces get tested. */
+static void setup_board(TetrisGame *g, int rows) {
+    Board *b = &g->board;
+    int top = b->height - rows;
+    memset(b->rows, 0, sizeof(RowMask) * b->height);
+    for (int y = top; y < b->height; y++) b->rows[y] = holey_row(g);
+    column_heights(b, g->heights);
+    stack_rows = rows;
+
+    for (int i = 0; i < PROBES; i++) {
+        Probe *p = &probes[i];
+        p->type = next_random(g) % 7;
+        p->rot = next_random(g) % 4;
+        p->x = (int)(next_random(g) % (b->width - 2));
+        p->y = top - 4 + (int)(next_random(g) % 8);
+    }
+}
+
+static void kernel_collides(TetrisGame *g, long iters) {
+    for (long i = 0; i < iters; i++) {
+        const Probe *p = &probes[i & (PROBES - 1)];
+        sink += collides(&g->board, p->type, p->x, p->y, p->rot);
+    }
+}
+
+static void kernel_landing(TetrisGame *g, long iters) {
+    for (long i = 0; i < iters; i++) {
+        const Probe *p = &probes[i & (PROBES - 1)];
+        sink += landing_y(&g->board, g->heights, p->type, p->x, 0, p->rot);
+    }
+}
+
+/* Complete the bottom row, clear it, then put a row back on top so the
+   stack keeps its height. */
+static void kernel_clear(TetrisGame *g, long iters) {
+    Board *b = &g->board;
+    int top = b->height - stack_rows;
+    for (long i = 0; i < iters; i++) {
+        b->rows[b->height - 1] = b->full;
+        sink += clear_lines(g);
+
+        RowMask r = holey_row(g);
+        b->rows[top] = r;
+        for (; r; r &= r - 1) {
+            int x = __builtin_ctzll(r);
+            if (g->heights[x] < b->height - top) g->heights[x] = b->height - top;
+        }
+    }
+}
+
+static double ns_per_call(void (*kernel)(TetrisGame *, long), TetrisGame *g, double budget) {
+    long calls = 0;
+    double start = now_seconds(), elapsed = 0;
+    while (elapsed < budget) {
+        kernel(g, 1024);
+        calls += 1024;
+        elapsed = now_seconds() - start;
+    }
+    return elapsed * 1e9 / calls;
+}
+
+static void scaling(double budget) {
+    static const int widths[] = { 10, 32, 64 };
+    static const int heights[] = { 20, 200, 2000, 16000 };
+
+    printf("%-9s %11s %11s %15s %15s\n", "board", "collides", "landing_y",
+           "clear (8 rows)", "clear (half)");
+    for (int wi = 0; wi < 3; wi++) {
+        for (int hi = 0; hi < 4; hi++) {
+            TetrisGame g;
+            init_game_size(&g, widths[wi], heights[hi], 1, 0);
+
+            setup_board(&g, 8);
+            double coll = ns_per_call(kernel_collides, &g, budget);
+            double land = ns_per_call(kernel_landing, &g, budget);
+            double shallow = ns_per_call(kernel_clear, &g, budget);
+            setup_board(&g, heights[hi] / 2);
+            double deep = ns_per_call(kernel_clear, &g, budget);
+            free_game(&g);
+
+            char size[32];
+            snprintf(size, sizeof(size), "%dx%d", widths[wi], heights[hi]);
+            printf("%-9s %8.1f ns %8.1f ns %12.1f ns %12.1f ns\n", size, coll, land, shallow, deep);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    init_piece_masks();
+    if (argc > 1 && strcmp(argv[1], "--scaling") == 0) {
+        scaling(argc > 2 ? atof(argv[2]) : 0.1);
+        return 0;
+    }
+
+    double seconds = argc > 1 ? atof(argv[1]) : 2.0;
+    TetrisGame game = { 0 };
+    long games = 0, pieces = 0, lines = 0;
+    double start = now_seconds(), elapsed = 0;
+
+    /* Check the clock only every batch of games to keep it off the profile */
+    while (elapsed < seconds) {
+        for (int i = 0; i < 1024; i++) {
+            pieces += play_game(&game, (uint64_t)games + 1);
+            lines += game.lines;
+            games++;
+        }
+        elapsed = now_seconds() - start;
+    }
+
+    printf("games:  %ld in %.2fs (%.0f games/s)\n", games, elapsed, games / elapsed);
+    printf("pieces: %ld (%.0f pieces/s, %.1f per game)\n", pieces, pieces / elapsed,
+           (double)pieces / games);
+    printf("lines:  %ld\n", lines);
+    free_game(&game);
+    return 0;
+}
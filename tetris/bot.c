@@ -0,0 +1,685 @@
+#define _POSIX_C_SOURCE 200809L
+#include "bot.h"
+#include "pool.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Weights from Yiyuan Lee's tuned four-feature heuristic, plus a light
+   well penalty. */
+const BotWeights BOT_DEFAULT_WEIGHTS = {
+    -0.510066,  /* height */
+     0.760666,  /* lines */
+    -0.35663,   /* holes */
+    -0.184483,  /* bumpiness */
+    -0.05,      /* wells */
+};
+
+#define LOSS -1e9
+#define ALL_TYPES 0x7F
+
+/* BFS state space: x in [-3, width), y from 8 rows above the start to
+   the floor, 4 rotations */
+#define BFS_X_OFF 3
+#define BFS_Y_OFF 8
+#define MAX_PLACEMENTS BOT_MAX_PLACEMENTS
+
+/* Rows kept above the stack when the search crops a tall board: free air
+   plus what BOT_MAX_DEPTH pieces can add, with room to spare. */
+#define CROP_MARGIN 32
+
+typedef struct {
+    int x, y, rotation;
+} Placement;
+
+/* Pieces the search can still play: a hold slot, the known queue and the
+   set of types the current 7-bag has left to deal after the queue. */
+typedef struct {
+    int hold;
+    int queue[2];
+    int qlen;
+    unsigned bag;
+} Pieces;
+
+typedef struct {
+    const Bot *bot;
+    long deadline;
+    long placements;
+    int aborted;
+} SearchCtx;
+
+typedef struct {
+    SearchCtx ctx;
+    int type;
+    Placement placement;
+    int use_hold;
+    Pieces after;
+    int depth;
+    Board board;
+    double value;
+} RootTask;
+
+static long clock_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+static void spawn_position(const Board *b, int type, Tetromino *p) {
+    p->type = type;
+    p->x = (b->width - SHAPES[type].grid_size) / 2;
+    p->y = 0;
+    p->rotation = 0;
+    p->color = SHAPES[type].color;
+}
+
+static int top_row(const Board *b) {
+    int y = 0;
+    while (y < b->height && !b->rows[y]) y++;
+    return y;
+}
+
+/* Rows above top - 7 are out of reach of every cell and kick of a piece
+   sitting there, so moves behave the same at any height in that band and
+   the search can start from its bottom. */
+static int free_air_y(const Board *b, int y) {
+    int free_y = top_row(b) - 7;
+    return free_y > y ? free_y : y;
+}
+
+typedef struct {
+    int w, h, y0;       /* columns, rows, first row */
+    int states;
+} BfsSpace;
+
+static BfsSpace bfs_space(const Board *b, const Tetromino *start) {
+    BfsSpace sp;
+    sp.w = b->width + BFS_X_OFF;
+    sp.y0 = start->y - BFS_Y_OFF;
+    sp.h = b->height - sp.y0;
+    sp.states = 4 * sp.w * sp.h;
+    return sp;
+}
+
+static int state_index(const BfsSpace *sp, int x, int y, int rot) {
+    return (rot * sp->h + (y - sp->y0)) * sp->w + (x + BFS_X_OFF);
+}
+
+typedef struct {
+    int *parent;
+    unsigned char *action;
+    int cap;
+} BfsTrace;
+
+/* Per-thread BFS buffers, grown to the largest state space seen and
+   freed when the thread exits */
+typedef struct {
+    unsigned char *seen;
+    int *queue;
+    int cap;
+} BfsScratch;
+
+static pthread_key_t scratch_key;
+static pthread_once_t scratch_once = PTHREAD_ONCE_INIT;
+
+static void free_scratch(void *arg) {
+    BfsScratch *s = arg;
+    free(s->seen);
+    free(s->queue);
+    free(s);
+}
+
+static void make_scratch_key(void) {
+    pthread_key_create(&scratch_key, free_scratch);
+}
+
+static BfsScratch *get_scratch(int states) {
+    pthread_once(&scratch_once, make_scratch_key);
+    BfsScratch *s = pthread_getspecific(scratch_key);
+    if (!s) {
+        s = calloc(1, sizeof(*s));
+        pthread_setspecific(scratch_key, s);
+    }
+    if (s->cap < states) {
+        s->seen = realloc(s->seen, states);
+        s->queue = realloc(s->queue, sizeof(int) * states);
+        s->cap = states;
+    }
+    return s;
+}
+
+struct Bot {
+    ThreadPool *pool;
+    BotWeights weights;
+    RootTask roots[2 * MAX_PLACEMENTS];
+    BfsTrace trace;
+};
+
+/*
+ * Breadth-first search over left/right/down/rotate from `start`. Every
+ * state that cannot move down is a resting placement; placements covering
+ * the same cells are reported once. With `trace`, stops as soon as
+ * `target` is reached and records parents for path reconstruction.
+ */
+static int explore(const Board *b, const Tetromino *start, Placement *out,
+                   BfsTrace *trace, const Tetromino *target) {
+    BfsSpace sp = bfs_space(b, start);
+    BfsScratch *scratch = get_scratch(sp.states);
+    unsigned char *seen = scratch->seen;
+    int *queue = scratch->queue;
+    RowMask cells[MAX_PLACEMENTS][4];
+    int bases[MAX_PLACEMENTS];
+    int head = 0, tail = 0, count = 0;
+    int type = start->type;
+
+    memset(seen, 0, sp.states);
+    int s0 = state_index(&sp, start->x, start->y, start->rotation);
+    seen[s0] = 1;
+    queue[tail++] = s0;
+    if (trace) trace->parent[s0] = -1;
+
+    while (head < tail) {
+        int s = queue[head++];
+        int x = s % sp.w - BFS_X_OFF;
+        int y = (s / sp.w) % sp.h + sp.y0;
+        int rot = s / (sp.w * sp.h);
+
+        if (trace && x == target->x && y == target->y && rot == target->rotation) return 1;
+
+        /* Resting placement? Dedupe by covered cells */
+        if (!trace && collides(b, type, x, y + 1, rot) && count < MAX_PLACEMENTS) {
+            const PieceMask *m = &piece_masks[type][rot];
+            RowMask c[4] = {0};
+            for (int i = m->min_y; i <= m->max_y; i++) {
+                c[i - m->min_y] = x >= 0 ? m->rows[i] << x : m->rows[i] >> -x;
+            }
+            int base = y + m->min_y, dup = 0;
+            for (int k = 0; k < count && !dup; k++) {
+                dup = bases[k] == base && !memcmp(cells[k], c, sizeof(c));
+            }
+            if (!dup) {
+                memcpy(cells[count], c, sizeof(c));
+                bases[count] = base;
+                out[count].x = x;
+                out[count].y = y;
+                out[count].rotation = rot;
+                count++;
+            }
+        }
+
+        for (int a = INPUT_LEFT; a <= INPUT_ROTATE_CCW; a++) {
+            Tetromino p = { x, y, type, rot, 0 };
+            int ok;
+            switch (a) {
+                case INPUT_LEFT:      ok = !collides(b, type, x - 1, y, rot); p.x--; break;
+                case INPUT_RIGHT:     ok = !collides(b, type, x + 1, y, rot); p.x++; break;
+                case INPUT_SOFT_DROP: ok = !collides(b, type, x, y + 1, rot); p.y++; break;
+                case INPUT_ROTATE_CW: ok = kick_rotate(b, &p, 1); break;
+                default:              ok = kick_rotate(b, &p, -1); break;
+            }
+            if (!ok || p.y < sp.y0) continue;
+            int n = state_index(&sp, p.x, p.y, p.rotation);
+            if (seen[n]) continue;
+            seen[n] = 1;
+            queue[tail++] = n;
+            if (trace) {
+                trace->parent[n] = s;
+                trace->action[n] = a;
+            }
+        }
+    }
+    return count;
+}
+
+/* Copy `b` into `out` (same size, own rows), lock the placement into the
+   copy and clear full lines. Returns the number of lines cleared. */
+static int place(const Board *b, int type, const Placement *pl, Board *out) {
+    const PieceMask *m = &piece_masks[type][pl->rotation];
+    RowMask *rows = out->rows;
+    memcpy(rows, b->rows, sizeof(RowMask) * b->height);
+    for (int i = m->min_y; i <= m->max_y; i++) {
+        int by = pl->y + i;
+        if (by < 0) continue;
+        rows[by] |= pl->x >= 0 ? m->rows[i] << pl->x : m->rows[i] >> -pl->x;
+    }
+
+    int dst = b->height - 1, lines = 0;
+    for (int y = b->height - 1; y >= 0; y--) {
+        if (rows[y] == b->full) {
+            lines++;
+            continue;
+        }
+        rows[dst--] = rows[y];
+    }
+    while (dst >= 0) rows[dst--] = 0;
+    return lines;
+}
+
+/* A scratch board the size of `b`, with rows in caller storage. */
+static Board board_like(const Board *b, RowMask *rows) {
+    Board out = *b;
+    out.rows = rows;
+    return out;
+}
+
+double bot_evaluate(const BotWeights *w, const Board *b) {
+    int heights[BOARD_MAX_WIDTH] = {0};
+    RowMask seen = 0;
+    int holes = 0;
+
+    /* Top-down: a column's height is set by its first filled cell, and
+       every empty cell under a seen column is a hole */
+    for (int y = top_row(b); y < b->height; y++) {
+        RowMask r = b->rows[y];
+        holes += __builtin_popcountll(seen & ~r);
+        RowMask fresh = r & ~seen;
+        while (fresh) {
+            heights[__builtin_ctzll(fresh)] = b->height - y;
+            fresh &= fresh - 1;
+        }
+        seen |= r;
+    }
+
+    int aggregate = 0, bumpiness = 0, wells = 0;
+    for (int x = 0; x < b->width; x++) {
+        aggregate += heights[x];
+        if (x > 0) bumpiness += abs(heights[x] - heights[x - 1]);
+        int left = x > 0 ? heights[x - 1] : b->height;
+        int right = x < b->width - 1 ? heights[x + 1] : b->height;
+        int depth = (left < right ? left : right) - heights[x];
+        if (depth > 0) wells += depth;
+    }
+
+    return w->height * aggregate + w->holes * holes +
+           w->bumpiness * bumpiness + w->wells * wells;
+}
+
+static double search(SearchCtx *c, const Board *b, const Pieces *pc, int depth);
+
+typedef struct {
+    int index;
+    double value;
+} Scored;
+
+static int by_value_desc(const void *a, const void *b) {
+    double d = ((const Scored *)b)->value - ((const Scored *)a)->value;
+    return (d > 0) - (d < 0);
+}
+
+/* Best value of playing `type` on `b` with `depth` plies to go
+   (this one included). Below the root only the BOT_BEAM best placements
+   by static score are searched further. */
+static double best_move(SearchCtx *c, const Board *b, int type, const Pieces *after, int depth) {
+    const BotWeights *w = &c->bot->weights;
+    Tetromino spawn;
+    spawn_position(b, type, &spawn);
+    if (collides(b, type, spawn.x, spawn.y, spawn.rotation)) return LOSS;
+    spawn.y = free_air_y(b, spawn.y);
+
+    Placement list[MAX_PLACEMENTS];
+    Scored scored[MAX_PLACEMENTS];
+    RowMask rows[b->height];
+    Board next = board_like(b, rows);
+    int n = explore(b, &spawn, list, NULL, NULL);
+    c->placements += n;
+    if (n == 0) return LOSS;
+
+    for (int i = 0; i < n; i++) {
+        int lines = place(b, type, &list[i], &next);
+        scored[i].index = i;
+        scored[i].value = w->lines * lines + bot_evaluate(w, &next);
+    }
+    qsort(scored, n, sizeof(Scored), by_value_desc);
+    if (depth <= 1) return scored[0].value;
+
+    double best = LOSS;
+    for (int i = 0; i < n && i < BOT_BEAM; i++) {
+        int lines = place(b, type, &list[scored[i].index], &next);
+        double v = w->lines * lines + search(c, &next, after, depth - 1);
+        if (v > best) best = v;
+    }
+    return best;
+}
+
+/* Value of a board with `depth` plies left to play from `pc`. Once the
+   known queue is used up, average over what the bag may deal next. */
+static double search(SearchCtx *c, const Board *b, const Pieces *pc, int depth) {
+    if (clock_us() > c->deadline) {
+        c->aborted = 1;
+        return 0;
+    }
+
+    if (pc->qlen == 0) {
+        unsigned bag = pc->bag ? pc->bag : ALL_TYPES;
+        double sum = 0;
+        int n = 0;
+        for (int t = 0; t < 7; t++) {
+            if (!(bag & (1u << t))) continue;
+            Pieces next = { pc->hold, {0, 0}, 0, bag & ~(1u << t) };
+            sum += best_move(c, b, t, &next, depth);
+            n++;
+        }
+        return sum / n;
+    }
+
+    /* Play the head of the queue... */
+    Pieces next = { pc->hold, {pc->queue[1], 0}, pc->qlen - 1, pc->bag };
+    double best = best_move(c, b, pc->queue[0], &next, depth);
+
+    /* ...or swap it with the hold slot */
+    if (pc->hold >= 0) {
+        next.hold = pc->queue[0];
+        double v = best_move(c, b, pc->hold, &next, depth);
+        if (v > best) best = v;
+    } else if (pc->qlen >= 2) {
+        Pieces held = { pc->queue[0], {0, 0}, 0, pc->bag };
+        double v = best_move(c, b, pc->queue[1], &held, depth);
+        if (v > best) best = v;
+    }
+    return best;
+}
+
+static void root_task(void *arg) {
+    RootTask *t = arg;
+    const BotWeights *w = &t->ctx.bot->weights;
+    RowMask rows[t->board.height];
+    Board next = board_like(&t->board, rows);
+
+    int lines = place(&t->board, t->type, &t->placement, &next);
+    t->ctx.placements = 0;
+    t->ctx.aborted = 0;
+    if (t->depth <= 1) {
+        t->value = w->lines * lines + bot_evaluate(w, &next);
+    } else {
+        t->value = w->lines * lines + search(&t->ctx, &next, &t->after, t->depth - 1);
+    }
+}
+
+Bot *bot_create(int threads, const BotWeights *weights) {
+    Bot *bot = calloc(1, sizeof(Bot));
+    bot->pool = pool_create(threads);
+    bot->weights = weights ? *weights : BOT_DEFAULT_WEIGHTS;
+    return bot;
+}
+
+void bot_destroy(Bot *bot) {
+    if (!bot) return;
+    pool_destroy(bot->pool);
+    free(bot->trace.parent);
+    free(bot->trace.action);
+    free(bot);
+}
+
+/* Types the current bag still holds after the NEXT piece. */
+static unsigned bag_remaining(const TetrisGame *g) {
+    unsigned bag = 0;
+    for (int i = g->bag_ptr; i < 7; i++) bag |= 1u << g->bag[i];
+    return bag;
+}
+
+/* The part of the board the search looks at: on a tall board, everything
+   more than CROP_MARGIN rows above the stack is empty and out of reach, so
+   it is cut off to keep copies and scans proportional to the stack. */
+static int crop_offset(const TetrisGame *g) {
+    int top = 0;
+    for (int x = 0; x < g->board.width; x++) {
+        if (g->heights[x] > top) top = g->heights[x];
+    }
+    int off = g->board.height - top - CROP_MARGIN;
+    return off > 0 ? off : 0;
+}
+
+static Board crop(const TetrisGame *g, int off) {
+    Board b = g->board;
+    b.rows += off;
+    b.height -= off;
+    return b;
+}
+
+static int add_roots(const Board *b, const Tetromino *start, int use_hold,
+                     const Pieces *after, RootTask *roots, int count) {
+    Tetromino s = *start;
+    if (collides(b, s.type, s.x, s.y, s.rotation)) return count;
+    s.y = free_air_y(b, s.y);
+
+    Placement list[MAX_PLACEMENTS];
+    int n = explore(b, &s, list, NULL, NULL);
+    for (int i = 0; i < n && count < 2 * MAX_PLACEMENTS; i++) {
+        RootTask *t = &roots[count++];
+        memset(t, 0, sizeof(*t));
+        t->type = s.type;
+        t->placement = list[i];
+        t->use_hold = use_hold;
+        t->after = *after;
+        t->board = *b;
+    }
+    return count;
+}
+
+int bot_think(Bot *bot, const TetrisGame *g, long budget_us, BotMove *move, BotStats *stats) {
+    long start_time = clock_us();
+    RootTask *roots = bot->roots;
+    int count = 0;
+    unsigned bag = bag_remaining(g);
+    int off = crop_offset(g);
+    Board board = crop(g, off);
+
+    /* Play the current piece as is, in cropped coordinates... */
+    Tetromino current = g->current;
+    current.y -= off;
+    Pieces after = { g->hold_type, {g->next_type, 0}, 1, bag };
+    count = add_roots(&board, &current, 0, &after, roots, count);
+
+    /* ...or hold it first */
+    if (g->can_hold) {
+        Tetromino held;
+        if (g->hold_type >= 0) {
+            spawn_position(&board, g->hold_type, &held);
+            Pieces a = { g->current.type, {g->next_type, 0}, 1, bag };
+            count = add_roots(&board, &held, 1, &a, roots, count);
+        } else {
+            spawn_position(&board, g->next_type, &held);
+            Pieces a = { g->current.type, {0, 0}, 0, bag };
+            count = add_roots(&board, &held, 1, &a, roots, count);
+        }
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    if (count == 0) return 0;
+
+    int best = 0;
+    for (int depth = 1; depth <= BOT_MAX_DEPTH; depth++) {
+        /* Depth 1 always completes so there is a move to play */
+        long deadline = depth == 1 ? LONG_MAX : start_time + budget_us;
+        for (int i = 0; i < count; i++) {
+            roots[i].ctx.bot = bot;
+            roots[i].ctx.deadline = deadline;
+            roots[i].depth = depth;
+            pool_submit(bot->pool, root_task, &roots[i]);
+        }
+        pool_wait(bot->pool);
+
+        int aborted = 0, depth_best = 0;
+        for (int i = 0; i < count; i++) {
+            stats->placements += roots[i].ctx.placements + 1;
+            aborted |= roots[i].ctx.aborted;
+            if (roots[i].value > roots[depth_best].value) depth_best = i;
+        }
+        if (aborted) break;
+
+        best = depth_best;
+        stats->depth = depth;
+        if (clock_us() - start_time > budget_us / 2) break;
+    }
+
+    /* Recover the input sequence for the chosen placement */
+    const RootTask *r = &roots[best];
+    Tetromino s;
+    if (r->use_hold) spawn_position(&board, r->type, &s);
+    else s = current;
+    s.y = free_air_y(&board, s.y);
+
+    BfsSpace sp = bfs_space(&board, &s);
+    BfsTrace *trace = &bot->trace;
+    if (trace->cap < sp.states) {
+        trace->parent = realloc(trace->parent, sizeof(int) * sp.states);
+        trace->action = realloc(trace->action, sp.states);
+        trace->cap = sp.states;
+    }
+    Tetromino target = { r->placement.x, r->placement.y, r->type, r->placement.rotation, SHAPES[r->type].color };
+    explore(&board, &s, NULL, trace, &target);
+
+    move->use_hold = r->use_hold;
+    move->start_y = s.y + off;
+    move->target = target;
+    move->target.y += off;
+    move->path_len = 0;
+    int st = state_index(&sp, target.x, target.y, target.rotation);
+    unsigned char reversed[BOT_MAX_PATH];
+    while (trace->parent[st] >= 0 && move->path_len < BOT_MAX_PATH) {
+        reversed[move->path_len++] = trace->action[st];
+        st = trace->parent[st];
+    }
+    if (trace->parent[st] >= 0) {
+        /* Too long to replay, e.g. down a very deep well: drop straight */
+        move->path_len = 0;
+    }
+    for (int i = 0; i < move->path_len; i++) {
+        move->path[i] = reversed[move->path_len - 1 - i];
+    }
+
+    stats->elapsed_us = clock_us() - start_time;
+    return 1;
+}
+
+int bot_reachable(const Board *b, const Tetromino *start, Tetromino *out) {
+    Tetromino s = *start;
+    if (collides(b, s.type, s.x, s.y, s.rotation)) return 0;
+    s.y = free_air_y(b, s.y);
+
+    Placement list[MAX_PLACEMENTS];
+    int n = explore(b, &s, list, NULL, NULL);
+    for (int i = 0; i < n; i++) {
+        Tetromino t = { list[i].x, list[i].y, s.type, list[i].rotation, SHAPES[s.type].color };
+        out[i] = t;
+    }
+    return n;
+}
+
+/* Best placement of `start`'s piece by static score, LOSS if it has none. */
+static double greedy_best(const BotWeights *w, const Board *b, const Tetromino *start, Placement *best) {
+    Tetromino s = *start;
+    if (collides(b, s.type, s.x, s.y, s.rotation)) return LOSS;
+    s.y = free_air_y(b, s.y);
+
+    Placement list[MAX_PLACEMENTS];
+    RowMask rows[b->height];
+    Board next = board_like(b, rows);
+    int n = explore(b, &s, list, NULL, NULL);
+    double best_value = LOSS;
+    for (int i = 0; i < n; i++) {
+        int lines = place(b, s.type, &list[i], &next);
+        double v = w->lines * lines + bot_evaluate(w, &next);
+        if (v > best_value) {
+            best_value = v;
+            *best = list[i];
+        }
+    }
+    return best_value;
+}
+
+int bot_greedy(const BotWeights *w, const TetrisGame *g, int *use_hold, Tetromino *target) {
+    int off = crop_offset(g);
+    Board board = crop(g, off);
+    Tetromino current = g->current;
+    current.y -= off;
+
+    Placement pl;
+    double best = greedy_best(w, &board, &current, &pl);
+    int type = current.type;
+    *use_hold = 0;
+    if (g->can_hold) {
+        Tetromino held;
+        Placement alt;
+        spawn_position(&board, g->hold_type >= 0 ? g->hold_type : g->next_type, &held);
+        double v = greedy_best(w, &board, &held, &alt);
+        if (v > best) {
+            best = v;
+            pl = alt;
+            type = held.type;
+            *use_hold = 1;
+        }
+    }
+    if (best <= LOSS) return 0;
+
+    Tetromino t = { pl.x, pl.y + off, type, pl.rotation, SHAPES[type].color };
+    *target = t;
+    return 1;
+}
+
+/* --- Weight files --- */
+
+static const char *WEIGHT_NAMES[] = { "height", "lines", "holes", "bumpiness", "wells" };
+#define WEIGHT_COUNT 5
+
+static double *weight_field(BotWeights *w, int i) {
+    double *fields[WEIGHT_COUNT] = { &w->height, &w->lines, &w->holes, &w->bumpiness, &w->wells };
+    return fields[i];
+}
+
+int bot_load_weights(BotWeights *w, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+
+    BotWeights loaded = BOT_DEFAULT_WEIGHTS;
+    char line[128], name[32];
+    double value;
+    int ok = 1;
+    while (ok && fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        ok = 0;
+        if (sscanf(line, "%31s %lf", name, &value) != 2) break;
+        for (int i = 0; i < WEIGHT_COUNT && !ok; i++) {
+            if (strcmp(name, WEIGHT_NAMES[i]) == 0) {
+                *weight_field(&loaded, i) = value;
+                ok = 1;
+            }
+        }
+    }
+    fclose(f);
+    if (ok) *w = loaded;
+    return ok;
+}
+
+int bot_save_weights(const BotWeights *w, const char *path, const char *comment) {
+    FILE *f = fopen(path, "w");
+    if (!f) return 0;
+    if (comment) fprintf(f, "# %s\n", comment);
+    for (int i = 0; i < WEIGHT_COUNT; i++) {
+        fprintf(f, "%-10s %.9f\n", WEIGHT_NAMES[i], *weight_field((BotWeights *)w, i));
+    }
+    return fclose(f) == 0;
+}
+
+int bot_inputs(const BotMove *move, const TetrisGame *g, unsigned char *inputs, int max) {
+    int n = 0;
+    int y = g->current.y;
+    if (move->use_hold && n < max) {
+        inputs[n++] = INPUT_HOLD;
+        y = 0;  /* the swapped-in piece spawns at the top */
+    }
+    for (; y < move->start_y && n < max; y++) inputs[n++] = INPUT_SOFT_DROP;
+    for (int i = 0; i < move->path_len && n < max; i++) inputs[n++] = move->path[i];
+    if (n < max) inputs[n++] = INPUT_HARD_DROP;
+    return n;
+}
+
+void bot_apply(const BotMove *move, TetrisGame *g, long now) {
+    unsigned char inputs[BOT_MAX_INPUTS];
+    int n = bot_inputs(move, g, inputs, BOT_MAX_INPUTS);
+    for (int i = 0; i < n; i++) apply_input(g, inputs[i], now);
+}
@@ -0,0 +1,83 @@
+#ifndef BOT_H
+#define BOT_H
+
+/*
+ * Tetris bot: enumerates every reachable resting placement of the current
+ * and hold pieces, scores the resulting boards with a weighted heuristic
+ * and looks ahead through the NEXT preview (and, past that, over the pieces
+ * the 7-bag can still deal). Root placements are searched in parallel on a
+ * work-stealing pool with iterative deepening under a time budget.
+ */
+
+#include "tetris.h"
+
+#define BOT_MAX_DEPTH 4
+#define BOT_BUDGET_US 10000     /* default thinking time per piece */
+#define BOT_BEAM 6              /* children expanded per ply below the root */
+#define BOT_MAX_PATH 1024
+#define BOT_MAX_PLACEMENTS 512
+#define BOT_MAX_INPUTS (BOT_MAX_PATH + BOARD_MAX_HEIGHT + 2)
+
+typedef struct {
+    double height;      /* aggregate column height */
+    double lines;       /* per line cleared by a placement */
+    double holes;       /* empty cells with a filled cell above them */
+    double bumpiness;   /* sum of height steps between neighbouring columns */
+    double wells;       /* sum of depths of columns lower than both neighbours */
+} BotWeights;
+
+extern const BotWeights BOT_DEFAULT_WEIGHTS;
+
+typedef struct {
+    int use_hold;       /* press hold before moving */
+    int start_y;        /* soft drop to this row before following the path */
+    Tetromino target;   /* resting position reached by the path */
+    int path_len;
+    unsigned char path[BOT_MAX_PATH];   /* INPUT_* codes, hard drop not included */
+} BotMove;
+
+typedef struct {
+    long placements;    /* placements evaluated for this decision */
+    int depth;          /* deepest ply searched to completion */
+    long elapsed_us;
+} BotStats;
+
+typedef struct Bot Bot;
+
+/* threads <= 0 means one worker per online CPU. */
+Bot *bot_create(int threads, const BotWeights *weights);
+void bot_destroy(Bot *bot);
+
+/* Pick a placement for the current piece. Returns 0 if the piece has no
+   legal placement at all. */
+int bot_think(Bot *bot, const TetrisGame *g, long budget_us, BotMove *move, BotStats *stats);
+
+/* Expand a decision into the full INPUT_* sequence a player would press,
+   ending in a hard drop. Returns the number of inputs written. */
+int bot_inputs(const BotMove *move, const TetrisGame *g, unsigned char *inputs, int max);
+
+/* Play a decision through apply_input(). */
+void bot_apply(const BotMove *move, TetrisGame *g, long now);
+
+/* Static board score, excluding the line clear reward. */
+double bot_evaluate(const BotWeights *w, const Board *b);
+
+/* Every distinct resting position `start`'s piece can reach on `b` with
+   the game's moves and SRS kicks; positions covering the same cells are
+   reported once. `out` needs room for BOT_MAX_PLACEMENTS. */
+int bot_reachable(const Board *b, const Tetromino *start, Tetromino *out);
+
+/* One-ply choice without lookahead, threads or a time limit: the resting
+   position of the current piece, or of the held piece swapped in when
+   *use_hold is set, that scores best. The same game always plays out the
+   same way, which is what weight tuning needs. The target is reachable,
+   so a caller may lock it in place directly. Returns 0 if no piece fits. */
+int bot_greedy(const BotWeights *w, const TetrisGame *g, int *use_hold, Tetromino *target);
+
+/* Weight files hold one "name value" line per field; '#' starts a
+   comment and missing fields keep their defaults. Both return 0 on
+   failure. */
+int bot_load_weights(BotWeights *w, const char *path);
+int bot_save_weights(const BotWeights *w, const char *path, const char *comment);
+
+#endif
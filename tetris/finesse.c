@@ -0,0 +1,210 @@
+#include "finesse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TABLE_HEIGHT 20     /* board the table is searched on; only the top matters */
+#define X_OFF 3
+
+static FinesseTable *tables[BOARD_MAX_WIDTH + 1];
+
+static const char *KEY_NAMES[] = { "left", "right", "DAS left", "DAS right", "cw", "ccw" };
+
+static int entry_len(FinesseEntry e) {
+    return (int)(e & 31);
+}
+
+static FinesseEntry entry_append(FinesseEntry e, int key) {
+    int n = entry_len(e);
+    return ((e & ~(FinesseEntry)31) | (FinesseEntry)key << (5 + 3 * n)) | (FinesseEntry)(n + 1);
+}
+
+/* Apply one key to the scratch game's piece. Returns 0 if nothing moved. */
+static int press(TetrisGame *g, int key) {
+    int dx = key == FINESSE_DAS_LEFT ? -1 : 1, moved = 0;
+    switch (key) {
+        case FINESSE_LEFT:  return move_piece(g, -1, 0, 0);
+        case FINESSE_RIGHT: return move_piece(g, 1, 0, 0);
+        case FINESSE_CW:    return rotate_piece(g, 1, 0);
+        case FINESSE_CCW:   return rotate_piece(g, -1, 0);
+    }
+    while (move_piece(g, dx, 0, 0)) moved = 1;
+    return moved;
+}
+
+/* Cells a piece covers once dropped onto an empty floor, bottom row
+   first, so rotations landing on the same cells compare equal. */
+static void floor_cells(int type, int rot, int x, RowMask cells[4]) {
+    const PieceMask *m = &piece_masks[type][rot];
+    memset(cells, 0, sizeof(RowMask) * 4);
+    for (int i = m->max_y; i >= m->min_y; i--) {
+        cells[m->max_y - i] = x >= 0 ? m->rows[i] << x : m->rows[i] >> -x;
+    }
+}
+
+/* Breadth-first over key presses from the spawn position; every press
+   costs one, so the first visit to a rotation and column is the cheapest. */
+static void search_type(FinesseTable *t, TetrisGame *g, int type) {
+    int w = t->width + X_OFF;
+    Tetromino queue[4 * (BOARD_MAX_WIDTH + X_OFF)];
+    int head = 0, tail = 0;
+    FinesseEntry *e = &t->entries[type][0][0];
+
+    spawn_piece(g, type, 0);
+    queue[tail++] = g->current;
+    e[g->current.rotation * (BOARD_MAX_WIDTH + X_OFF) + g->current.x + X_OFF] = 0;
+
+    while (head < tail) {
+        Tetromino from = queue[head++];
+        FinesseEntry seq = e[from.rotation * (BOARD_MAX_WIDTH + X_OFF) + from.x + X_OFF];
+        if (entry_len(seq) >= FINESSE_MAX_KEYS) continue;
+        for (int key = FINESSE_LEFT; key <= FINESSE_CCW; key++) {
+            g->current = from;
+            if (!press(g, key)) continue;
+            const Tetromino *to = &g->current;
+            if (to->x + X_OFF < 0 || to->x + X_OFF >= w) continue;
+            FinesseEntry *slot = &e[to->rotation * (BOARD_MAX_WIDTH + X_OFF) + to->x + X_OFF];
+            if (entry_len(*slot) != FINESSE_NONE) continue;
+            *slot = entry_append(seq, key);
+            queue[tail++] = *to;
+        }
+    }
+
+    /* Rotations resting on the same cells share the best sequence; such
+       positions line up on their leftmost occupied column */
+    for (int r = 0; r < 4; r++) {
+        for (int x = -X_OFF; x < t->width; x++) {
+            FinesseEntry *a = &t->entries[type][r][x + X_OFF];
+            if (entry_len(*a) == FINESSE_NONE) continue;
+            RowMask ca[4], cb[4];
+            floor_cells(type, r, x, ca);
+            for (int r2 = 0; r2 < 4; r2++) {
+                int x2 = x + piece_masks[type][r].min_x - piece_masks[type][r2].min_x;
+                if (r2 == r || x2 < -X_OFF || x2 >= t->width) continue;
+                FinesseEntry b = t->entries[type][r2][x2 + X_OFF];
+                if (entry_len(b) >= entry_len(*a)) continue;
+                floor_cells(type, r2, x2, cb);
+                if (!memcmp(ca, cb, sizeof(ca))) *a = b;
+            }
+        }
+    }
+}
+
+const FinesseTable *finesse_table(int width) {
+    if (tables[width]) return tables[width];
+
+    FinesseTable *t = malloc(sizeof(FinesseTable));
+    t->width = width;
+    for (int type = 0; type < 7; type++) {
+        for (int r = 0; r < 4; r++) {
+            for (int x = 0; x < BOARD_MAX_WIDTH + X_OFF; x++) t->entries[type][r][x] = FINESSE_NONE;
+        }
+    }
+
+    TetrisGame g;
+    init_game_size(&g, width, TABLE_HEIGHT, 0, 0);
+    for (int type = 0; type < 7; type++) search_type(t, &g, type);
+    free_game(&g);
+    tables[width] = t;
+    return t;
+}
+
+void finesse_describe(FinesseEntry e, char *buf, int size) {
+    int n = entry_len(e), len = 0;
+    buf[0] = '\0';
+    if (n == FINESSE_NONE) return;
+    if (n == 0) snprintf(buf, size, "none");
+    for (int i = 0; i < n && len < size; i++) {
+        int key = (int)((e >> (5 + 3 * i)) & 7);
+        len += snprintf(buf + len, size - len, "%s%s", i ? ", " : "", KEY_NAMES[key]);
+    }
+}
+
+/* --- Tracking --- */
+
+/* Nothing on the board above the active piece in any of its columns, so
+   it could have been dropped straight from there. */
+static int open_above(const TetrisGame *g) {
+    const Tetromino *p = &g->current;
+    const PieceMask *m = &piece_masks[p->type][p->rotation];
+    for (int j = m->min_x; j <= m->max_x; j++) {
+        int col = p->x + j;
+        if (g->board.height - g->heights[col] <= p->y + m->top[j]) return 0;
+    }
+    return 1;
+}
+
+static void end_run(Finesse *f) {
+    if (f->run_input < 0) return;
+    f->presses += f->run_blocked ? 1 : f->run_len;
+    f->run_input = -1;
+    f->run_len = 0;
+}
+
+static void start_piece(Finesse *f) {
+    f->presses = 0;
+    f->run_input = -1;
+    f->run_len = 0;
+    f->open = 1;
+}
+
+void finesse_init(Finesse *f, const TetrisGame *g) {
+    memset(f, 0, sizeof(*f));
+    f->table = finesse_table(g->board.width);
+    f->pieces_seen = g->pieces;
+    start_piece(f);
+}
+
+void finesse_sync(Finesse *f, const TetrisGame *g) {
+    if (g->pieces == f->pieces_seen) return;
+
+    /* Judge only when exactly the tracked piece locked */
+    end_run(f);
+    const Tetromino *p = &g->last_locked;
+    int best = finesse_keys(f->table, p->type, p->rotation, p->x);
+    if (g->pieces == f->pieces_seen + 1 && f->open && best >= 0) {
+        f->judged++;
+        if (f->presses > best) {
+            f->faults++;
+            f->extra += f->presses - best;
+            f->fault_piece = *p;
+            f->fault_presses = f->presses;
+            f->fault_best = f->table->entries[p->type][p->rotation][p->x + X_OFF];
+        }
+    }
+    f->pieces_seen = g->pieces;
+    start_piece(f);
+}
+
+void finesse_input(Finesse *f, const TetrisGame *g, int input) {
+    /* A hard drop has locked its piece by now, and any other input went
+       to whichever piece is current */
+    finesse_sync(f, g);
+    if (g->game_over) return;
+
+    switch (input) {
+        case INPUT_LEFT:
+        case INPUT_RIGHT: {
+            const Tetromino *p = &g->current;
+            int dx = input == INPUT_LEFT ? -1 : 1;
+            if (f->run_input != input) {
+                end_run(f);
+                f->run_input = input;
+            }
+            f->run_len++;
+            f->run_blocked = check_collision(g, p->type, p->x + dx, p->y, p->rotation);
+            f->open = open_above(g);
+            break;
+        }
+        case INPUT_ROTATE_CW:
+        case INPUT_ROTATE_CCW:
+            end_run(f);
+            f->presses++;
+            f->open = open_above(g);
+            break;
+        case INPUT_HOLD:
+            start_piece(f);
+            break;
+    }
+}
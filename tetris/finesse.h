@@ -0,0 +1,85 @@
+#ifndef FINESSE_H
+#define FINESSE_H
+
+/*
+ * Finesse: placing each piece with the fewest key presses.
+ *
+ * A FinesseTable holds, for every piece, rotation and column, the
+ * shortest key sequence that takes the piece from its spawn position to
+ * that column and rotation over an open surface. Holding a direction
+ * until the piece stops (DAS) counts as one press. The table is found by
+ * a breadth-first search that drives the game's own move_piece() and
+ * rotate_piece(), so it follows the SRS kicks exactly. Rotations that
+ * cover the same cells share the best sequence of the group. Each entry
+ * packs its whole sequence into one word, so a lookup is a single load.
+ *
+ * A Finesse tracker follows the inputs applied to a game and compares the
+ * presses spent on each piece with the table. A run of moves in one
+ * direction that ends against something counts as one DAS press, which
+ * makes live play and replays count alike. Pieces tucked or spun under
+ * an overhang are not judged.
+ */
+
+#include <stdint.h>
+
+#include "tetris.h"
+
+/* Keys in a sequence */
+enum { FINESSE_LEFT, FINESSE_RIGHT, FINESSE_DAS_LEFT, FINESSE_DAS_RIGHT, FINESSE_CW, FINESSE_CCW };
+
+/* Entry layout: the key count in bits 0-4, then 3 bits per key, first key
+   lowest. FINESSE_NONE marks positions the piece cannot reach. */
+typedef uint64_t FinesseEntry;
+#define FINESSE_MAX_KEYS 19
+#define FINESSE_NONE 31
+
+typedef struct {
+    int width;
+    FinesseEntry entries[7][4][BOARD_MAX_WIDTH + 3];  /* by type, rotation, x + 3 */
+} FinesseTable;
+
+/* The table for boards `width` columns wide, built on first use. Not
+   thread safe. */
+const FinesseTable *finesse_table(int width);
+
+/* Fewest presses that put `type` in column x, rotation `rot`; -1 if none. */
+static inline int finesse_keys(const FinesseTable *t, int type, int rot, int x) {
+    if (x < -3 || x >= t->width) return -1;
+    int n = (int)(t->entries[type][rot][x + 3] & 31);
+    return n == FINESSE_NONE ? -1 : n;
+}
+
+/* Spell out an entry, e.g. "DAS left, cw". */
+void finesse_describe(FinesseEntry e, char *buf, int size);
+
+typedef struct {
+    const FinesseTable *table;
+    int pieces_seen;        /* g->pieces as of the last call */
+
+    /* Current piece */
+    int presses;
+    int run_input;          /* INPUT_LEFT/RIGHT of the running move, -1 if none */
+    int run_len;
+    int run_blocked;        /* its last move ended against something */
+    int open;               /* nothing above the piece since its last move or turn */
+
+    /* Totals */
+    int judged;
+    int faults;
+    long extra;             /* presses beyond the fewest, summed over faults */
+
+    /* Most recent fault */
+    Tetromino fault_piece;
+    int fault_presses;
+    FinesseEntry fault_best;
+} Finesse;
+
+void finesse_init(Finesse *f, const TetrisGame *g);
+
+/* Call after every input applied to `g`. Constant time. */
+void finesse_input(Finesse *f, const TetrisGame *g, int input);
+
+/* Judge a piece gravity locked since the last call; call once per tick. */
+void finesse_sync(Finesse *f, const TetrisGame *g);
+
+#endif
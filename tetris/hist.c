@@ -0,0 +1,69 @@
+#include "hist.h"
+
+#include <string.h>
+
+static int bucket_index(long v) {
+    if (v < HIST_SUB_COUNT) return v < 0 ? 0 : (int)v;
+    int e = 63 - __builtin_clzll((unsigned long long)v);   /* >= HIST_SUB_BITS */
+    int sub = (int)(v >> (e - HIST_SUB_BITS)) & (HIST_SUB_COUNT - 1);
+    return (e - HIST_SUB_BITS + 1) * HIST_SUB_COUNT + sub;
+}
+
+/* Largest value that lands in bucket i. */
+static long bucket_top(int i) {
+    if (i < HIST_SUB_COUNT) return i;
+    int e = i / HIST_SUB_COUNT + HIST_SUB_BITS - 1;
+    long base = (long)(HIST_SUB_COUNT + i % HIST_SUB_COUNT) << (e - HIST_SUB_BITS);
+    return base + (1L << (e - HIST_SUB_BITS)) - 1;
+}
+
+void hist_reset(Histogram *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+void hist_record(Histogram *h, long value) {
+    if (value < 0) value = 0;
+    if (h->count == 0 || value < h->min) h->min = value;
+    if (value > h->max) h->max = value;
+    h->count++;
+    h->sum += value;
+    h->buckets[bucket_index(value)]++;
+}
+
+long hist_percentile(const Histogram *h, double p) {
+    if (h->count == 0) return 0;
+    long want = (long)(p / 100 * h->count + 0.5);
+    if (want < 1) want = 1;
+
+    long seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= want) {
+            long top = bucket_top(i);
+            return top < h->max ? top : h->max;
+        }
+    }
+    return h->max;
+}
+
+void hist_write(const Histogram *h, FILE *f, double scale) {
+    fprintf(f, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+
+    long seen = 0;
+    for (int i = 0; i < HIST_BUCKETS && seen < h->count; i++) {
+        if (!h->buckets[i]) continue;
+        seen += h->buckets[i];
+        long top = bucket_top(i);
+        double q = (double)seen / h->count;
+        if (seen < h->count) {
+            fprintf(f, "%12.3f %14.12f %10ld %14.2f\n", (top < h->max ? top : h->max) / scale,
+                    q, seen, 1 / (1 - q));
+        } else {
+            fprintf(f, "%12.3f %14.12f %10ld\n", h->max / scale, q, seen);
+        }
+    }
+
+    fprintf(f, "#[Mean    = %12.3f, Max   = %12.3f]\n",
+            h->count ? h->sum / h->count / scale : 0.0, h->max / scale);
+    fprintf(f, "#[Min     = %12.3f, Count = %12ld]\n", h->min / scale, h->count);
+}
@@ -0,0 +1,37 @@
+#ifndef HIST_H
+#define HIST_H
+
+/*
+ * HDR-style latency histogram.
+ *
+ * Values below HIST_SUB_COUNT get a bucket each; above that, every power
+ * of two is split into HIST_SUB_COUNT linear buckets, so any recorded
+ * value is known to within 1/HIST_SUB_COUNT (6.25%) across the whole
+ * range of a long, in a fixed 8 KB with no allocation.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define HIST_SUB_BITS 4
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS + 1) * HIST_SUB_COUNT)
+
+typedef struct {
+    long count;
+    long min, max;
+    double sum;
+    uint32_t buckets[HIST_BUCKETS];
+} Histogram;
+
+void hist_reset(Histogram *h);
+void hist_record(Histogram *h, long value);
+
+/* Highest value equivalent to the p-th percentile (0..100). */
+long hist_percentile(const Histogram *h, double p);
+
+/* Percentile distribution in the HdrHistogram text layout. Values are
+   divided by `scale` (e.g. 1000 to print microseconds as milliseconds). */
+void hist_write(const Histogram *h, FILE *f, double scale);
+
+#endif
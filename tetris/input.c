@@ -0,0 +1,187 @@
+#define _DEFAULT_SOURCE
+#include "input.h"
+
+#include <ncurses.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/select.h>
+#include <unistd.h>
+
+#define KITTY_FLAGS 11      /* disambiguate (1) | event types (2) | all keys as escapes (8) */
+#define PROBE_TIMEOUT 250000
+
+static int kitty = 0;
+static unsigned char buf[256];
+static int buf_len = 0;
+static int term_rows = 0, term_cols = 0;
+
+static void put(const char *s) {
+    ssize_t n = write(STDOUT_FILENO, s, strlen(s));
+    (void)n;
+}
+
+/* Read whatever is available, waiting at most `timeout` us for the first
+   byte. Returns 0 if nothing arrived. */
+static int fill(long timeout) {
+    if (buf_len == (int)sizeof(buf)) return 0;
+
+    struct timeval tv = { timeout / 1000000, timeout % 1000000 };
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(STDIN_FILENO, &fds);
+    if (select(STDIN_FILENO + 1, &fds, NULL, NULL, &tv) <= 0) return 0;
+
+    ssize_t n = read(STDIN_FILENO, buf + buf_len, sizeof(buf) - buf_len);
+    if (n <= 0) return 0;
+    buf_len += (int)n;
+    return 1;
+}
+
+static void consume(int n) {
+    memmove(buf, buf + n, buf_len - n);
+    buf_len -= n;
+}
+
+/* Length of the complete CSI/SS3 sequence at the start of buf, 0 if it is
+   still incomplete. */
+static int sequence_length(void) {
+    if (buf_len < 2) return 0;
+    if (buf[1] == 'O') return buf_len >= 3 ? 3 : 0;
+    if (buf[1] != '[') return 1;   /* lone ESC */
+    for (int i = 2; i < buf_len; i++) {
+        if (buf[i] >= 0x40 && buf[i] <= 0x7E) return i + 1;
+    }
+    return 0;
+}
+
+int input_init(void) {
+    cbreak();
+
+    /* Ask for the enhancement flags, then for the primary device
+       attributes, which every terminal answers. A flags reply before the
+       attributes reply means the protocol is supported. */
+    put("\x1b[?u\x1b[c");
+
+    int supported = 0;
+    long waited = 0;
+    while (waited < PROBE_TIMEOUT) {
+        if (!fill(50000)) {
+            waited += 50000;
+            continue;
+        }
+        int done = 0;
+        while (buf_len > 0 && !done) {
+            if (buf[0] != 0x1b) {
+                consume(1);
+                continue;
+            }
+            int n = sequence_length();
+            if (!n) break;
+            if (n > 3 && buf[2] == '?' && buf[n - 1] == 'u') supported = 1;
+            if (n > 3 && buf[2] == '?' && buf[n - 1] == 'c') done = 1;
+            consume(n);
+        }
+        if (done) break;
+    }
+    buf_len = 0;
+
+    if (supported) {
+        char push[16];
+        snprintf(push, sizeof(push), "\x1b[>%du", KITTY_FLAGS);
+        put(push);
+        kitty = 1;
+        getmaxyx(stdscr, term_rows, term_cols);
+    }
+    return kitty;
+}
+
+void input_shutdown(void) {
+    if (kitty) put("\x1b[<u");
+    kitty = 0;
+}
+
+/* getch() is not used in kitty mode, so nothing picks up SIGWINCH for
+   ncurses; check the size directly. */
+static void check_resize(void) {
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) != 0) return;
+    if (ws.ws_row != term_rows || ws.ws_col != term_cols) {
+        term_rows = ws.ws_row;
+        term_cols = ws.ws_col;
+        resizeterm(term_rows, term_cols);
+    }
+}
+
+/* Parse "CSI code[:alt];mods[:event] u", "CSI 1;mods[:event] A..D" or an
+   SS3 arrow. Absent fields read as 0. Returns 0 for sequences that are
+   not key events we use. */
+static int parse_key(const unsigned char *s, int n, KeyEvent *ev) {
+    int vals[2][2] = { { 0, 0 }, { 0, 0 } };
+    int field = 0, sub = 0;
+
+    for (int i = 2; s[1] == '[' && i < n - 1; i++) {
+        unsigned char c = s[i];
+        if (c >= '0' && c <= '9') {
+            if (field < 2 && sub < 2) vals[field][sub] = vals[field][sub] * 10 + (c - '0');
+        } else if (c == ':') {
+            sub++;
+        } else if (c == ';') {
+            field++;
+            sub = 0;
+        } else {
+            return 0;   /* private replies such as "CSI ? flags u" */
+        }
+    }
+
+    switch (s[n - 1]) {
+        case 'u': ev->ch = vals[0][0]; break;
+        case 'A': ev->ch = KEY_UP; break;
+        case 'B': ev->ch = KEY_DOWN; break;
+        case 'C': ev->ch = KEY_RIGHT; break;
+        case 'D': ev->ch = KEY_LEFT; break;
+        default: return 0;
+    }
+    switch (vals[1][1]) {
+        case 2: ev->kind = EV_REPEAT; break;
+        case 3: ev->kind = EV_RELEASE; break;
+        default: ev->kind = EV_PRESS; break;
+    }
+    return 1;
+}
+
+int input_poll(KeyEvent *ev) {
+    if (!kitty) {
+        int ch = getch();
+        if (ch == ERR) return 0;
+        ev->ch = ch;
+        ev->kind = EV_PRESS;
+        return 1;
+    }
+
+    check_resize();
+    while (1) {
+        if (buf_len == 0 && !fill(0)) return 0;
+        if (buf[0] != 0x1b) {
+            /* Plain text should not arrive with all keys as escapes, but
+               take it as a press if it does */
+            ev->ch = buf[0];
+            ev->kind = EV_PRESS;
+            consume(1);
+            return 1;
+        }
+
+        int n = sequence_length();
+        if (!n) {
+            /* Wait briefly for the rest of a split sequence */
+            if (!fill(10000)) {
+                buf_len = 0;
+                return 0;
+            }
+            continue;
+        }
+        int ok = n > 1 && parse_key(buf, n, ev);
+        consume(n);
+        if (ok) return 1;
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+/*
+ * Keyboard input backends.
+ *
+ * Plain terminals only send key presses and the terminal's own auto-repeat,
+ * so the game has to guess when a key is released. Terminals implementing
+ * the kitty progressive keyboard enhancement protocol can report press,
+ * repeat and release as separate events; input_init() probes for it and
+ * uses it when available, otherwise events come from getch() and every
+ * event is reported as a press.
+ */
+
+enum { EV_PRESS, EV_REPEAT, EV_RELEASE };
+
+typedef struct {
+    int ch;         /* character or ncurses KEY_* code, as getch() returns them */
+    int kind;       /* EV_* */
+} KeyEvent;
+
+/* Call after initscr(). Returns 1 if release events will be reported. */
+int input_init(void);
+void input_shutdown(void);
+
+/* Next pending key event without blocking; returns 0 when there is none. */
+int input_poll(KeyEvent *ev);
+
+#endif
@@ -4,157 +4,297 @@
 #include <time.h>
 #include <unistd.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/select.h>
 #include <sys/time.h>
 
-/* Constants */
-#define DELAY 5000          /* 5ms tick rate (approx 200 FPS for input) */
-#define DROP_RATE_INITIAL 500000 
-#define LOCK_DELAY 500000   /* 0.5s lock delay */
+#include "tetris.h"
+#include "bot.h"
+#include "replay.h"
+#include "render.h"
+#include "hist.h"
+#include "input.h"
+#include "versus.h"
+#include "net.h"
+#include "pc.h"
+#include "finesse.h"
 
-#define BOARD_WIDTH 10
-#define BOARD_HEIGHT 20
+/* Constants */
+#define DELAY 5000          /* 5ms: bot frame time, and replay wait cap */
 
-/* Structs */
-typedef struct {
-    int shape[4][4];
-    int color;
-    int grid_size; /* 2, 3, or 4 */
-} TetrominoDef;
+/* Global Variables */
+TetrisGame game;
+int board_width = BOARD_WIDTH, board_height = BOARD_HEIGHT;
+int quit_requested = 0;
 
-typedef struct {
-    int x;
-    int y;
-    int type;      
-    int rotation;  /* 0..3 */
-    int color;
-} Tetromino;
+/* Bot Mode State */
+Bot *bot = NULL;
+int bot_threads = 0;        /* 0 = one per CPU */
+long gravity_override = 0;  /* drop rate forced by --gravity, 0 = normal */
+BotStats bot_last;
+long bot_pieces = 0, bot_placements = 0, bot_think_us = 0;
+long bot_depth_hist[BOT_MAX_DEPTH + 1];
 
-/* Global Variables */
-int board[BOARD_HEIGHT][BOARD_WIDTH] = {0};
-Tetromino current_piece;
-int game_over = 0;
-int score = 0;
-long last_drop_time = 0;
-long drop_rate = DROP_RATE_INITIAL;
-long lock_timer = 0;
-
-/* Advanced Mechanics State */
-/* Advanced Mechanics State */
-int next_piece_type;
-int hold_piece_type = -1; /* -1 means empty */
-int can_hold = 1;
-
-/* Shapes Definition */
-const TetrominoDef SHAPES[7] = {
-    /* I - Type 0 */
-    { { {0,0,0,0}, {1,1,1,1}, {0,0,0,0}, {0,0,0,0} }, 1, 4 },
-    /* J - Type 1 */
-    { { {1,0,0,0}, {1,1,1,0}, {0,0,0,0}, {0,0,0,0} }, 2, 3 },
-    /* L - Type 2 */
-    { { {0,0,1,0}, {1,1,1,0}, {0,0,0,0}, {0,0,0,0} }, 3, 3 },
-    /* O - Type 3 */
-    { { {1,1,0,0}, {1,1,0,0}, {0,0,0,0}, {0,0,0,0} }, 4, 2 },
-    /* S - Type 4 */
-    { { {0,1,1,0}, {1,1,0,0}, {0,0,0,0}, {0,0,0,0} }, 5, 3 },
-    /* T - Type 5 */
-    { { {0,1,0,0}, {1,1,1,0}, {0,0,0,0}, {0,0,0,0} }, 6, 3 },
-    /* Z - Type 6 */
-    { { {1,1,0,0}, {0,1,1,0}, {0,0,0,0}, {0,0,0,0} }, 7, 3 }
-};
+/* Perfect Clear Hint State */
+int pc_lines = 0;               /* --pc N, 0 = off */
+PcHint *pc_hint = NULL;
+PcResult pc_last;               /* latest finished search, for the current piece */
+long pc_state = -1;             /* pieces and hold state the search was started for */
 
-/* --- LOGIC DEFINITIONS START --- */
+/* Finesse State: tracked in every game, shown with --finesse and in replays */
+Finesse finesse;
+int show_finesse = 0;
 
-/* Randomizer State */
-int bag[7];
-int bag_ptr = 7;
+/* Input Backend */
+int precise_keys = 0;           /* terminal reports key releases (kitty protocol) */
 
-void shuffle_bag() {
-    for (int i = 0; i < 7; i++) bag[i] = i;
-    for (int i = 6; i > 0; i--) {
-        int j = rand() % (i + 1);
-        int temp = bag[i];
-        bag[i] = bag[j];
-        bag[j] = temp;
-    }
-    bag_ptr = 0;
-}
+/* Display State */
+int show_stats = 0;             /* --stats overlay */
+const char *status_line = NULL; /* replaces the bot line when set */
 
-int next_from_bag() {
-    if (bag_ptr >= 7) shuffle_bag();
-    return bag[bag_ptr++];
-}
+/* Latency State: key-to-screen time per INPUT_*, measured from getch()
+   returning the key to refresh() having sent the resulting frame */
+#define MAX_PENDING_KEYS 64
+const char *latency_path = NULL;
+Histogram latency[INPUT_COUNT];
+int pending_input[MAX_PENDING_KEYS];
+long pending_time[MAX_PENDING_KEYS];
+int pending_keys = 0;
 
-/* SRS Wall Kick Data (J, L, S, T, Z) - Adapted for Y-Down (Screen) Coords */
-const int KICKS_JLSTZ[8][5][2] = {
-    {{0,0}, {-1,0}, {-1,-1}, { 0, 2}, {-1, 2}}, /* 0->1 */
-    {{0,0}, { 1,0}, { 1, 1}, { 0,-2}, { 1,-2}}, /* 1->0 */
-    {{0,0}, { 1,0}, { 1, 1}, { 0,-2}, { 1,-2}}, /* 1->2 */
-    {{0,0}, {-1,0}, {-1,-1}, { 0, 2}, {-1, 2}}, /* 2->1 */
-    {{0,0}, { 1,0}, { 1,-1}, { 0, 2}, { 1, 2}}, /* 2->3 */
-    {{0,0}, {-1,0}, {-1, 1}, { 0,-2}, {-1,-2}}, /* 3->2 */
-    {{0,0}, {-1,0}, {-1, 1}, { 0,-2}, {-1,-2}}, /* 3->0 */
-    {{0,0}, { 1,0}, { 1,-1}, { 0, 2}, { 1, 2}}  /* 0->3 */
+const char *INPUT_NAMES[INPUT_COUNT] = {
+    "left", "right", "soft drop", "rotate cw", "rotate ccw", "hard drop", "hold"
 };
 
-const int KICKS_I[8][5][2] = {
-    {{0,0}, {-2,0}, { 1,0}, {-2, 1}, { 1,-2}}, /* 0->1 */
-    {{0,0}, { 2,0}, {-1,0}, { 2,-1}, {-1, 2}}, /* 1->0 */
-    {{0,0}, {-1,0}, { 2,0}, {-1,-2}, { 2, 1}}, /* 1->2 */
-    {{0,0}, { 1,0}, {-2,0}, { 1, 2}, {-2,-1}}, /* 2->1 */
-    {{0,0}, { 2,0}, {-1,0}, { 2,-1}, {-1, 2}}, /* 2->3 */
-    {{0,0}, {-2,0}, { 1,0}, {-2, 1}, { 1,-2}}, /* 3->2 */
-    {{0,0}, { 1,0}, {-2,0}, { 1, 2}, {-2,-1}}, /* 3->0 */
-    {{0,0}, {-1,0}, { 2,0}, {-1,-2}, { 2, 1}}  /* 0->3 */
-};
+/* Replay State */
+const char *record_path = NULL;
+Replay recording;
 
-int get_kick_index(int old_rot, int new_rot) {
-    if (old_rot == 0 && new_rot == 1) return 0;
-    if (old_rot == 1 && new_rot == 0) return 1;
-    if (old_rot == 1 && new_rot == 2) return 2;
-    if (old_rot == 2 && new_rot == 1) return 3;
-    if (old_rot == 2 && new_rot == 3) return 4;
-    if (old_rot == 3 && new_rot == 2) return 5;
-    if (old_rot == 3 && new_rot == 0) return 6;
-    if (old_rot == 0 && new_rot == 3) return 7;
-    return 0;
-}
-/* --- LOGIC DEFINITIONS END --- */
+/* Versus State */
+int versus_player = 0;          /* --versus 1|2, 0 for single player */
+int versus_port = 7341;
+uint64_t versus_seed;
+Rollback session;
+uint8_t versus_mask = 0;        /* local inputs for the next frame */
+int pending_frame = -1;         /* frame the committed keys land in */
+int committed_keys = 0;         /* pending keys already sent in a frame */
+int peer_frame = 0, peer_advantage = 0;
+Histogram rollback_depth, rollback_us;
+long rollbacks = 0, stalls = 0, time_syncs = 0;
+
+/* Bot moves in versus go out one per frame */
+unsigned char bot_queue[BOT_MAX_INPUTS];
+int bot_queue_len = 0, bot_queue_pos = 0, bot_planned = -1;
 
 /* Prototypes */
 void init_ncurses();
 void reset_game();
 int show_game_over();
-void loop_game();
+long loop_game();
 void draw_board();
-void spawn_piece(int type);
-void new_piece();
-int check_collision(int px, int py, int prot);
-void rotate_piece(int dir);
-void move_piece(int dx, int dy);
-void hard_drop();
-void hold_piece();
-void lock_piece();
-void clear_lines();
+void draw_game(const TetrisGame *g, int center_x, int term_h, const Tetromino *hint);
+void draw_stats(int row);
+void draw_finesse(int row);
 long get_time_us();
-int get_block(int type, int rot, int x, int y);
+long get_time_ns();
+void wait_until(long deadline);
 
-int main() {
+void write_latency(const char *path);
+void play_replay(const char *path);
+int verify_replays(int count, char **paths);
+int versus_connect();
+void loop_versus();
+
+void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [--bot] [--threads N] [--weights FILE] [--gravity G] [--size WxH]\n"
+                    "       %*s [--pc N] [--finesse] [--stats] [--latency FILE] [--record FILE]\n", prog, (int)strlen(prog), "");
+    fprintf(stderr, "       %s --versus 1|2 [--port N] [--jitter MS] [--bot] [--size WxH] [--stats]\n", prog);
+    fprintf(stderr, "       %s --replay FILE\n", prog);
+    fprintf(stderr, "       %s --verify FILE...\n", prog);
+    fprintf(stderr, "  --bot          let the bot play (restarts on top-out, 'q' quits)\n");
+    fprintf(stderr, "  --threads N    bot search threads (default: one per CPU)\n");
+    fprintf(stderr, "  --weights FILE bot evaluation weights, e.g. from tetris_tune\n");
+    fprintf(stderr, "  --gravity G    fixed gravity in rows per 60Hz frame, e.g. 20 for 20G\n");
+    fprintf(stderr, "  --size WxH     board size, up to %dx%d (default %dx%d)\n",
+            BOARD_MAX_WIDTH, BOARD_MAX_HEIGHT, BOARD_WIDTH, BOARD_HEIGHT);
+    fprintf(stderr, "  --pc N         hint at a perfect clear within N lines (up to %d)\n", PC_MAX_LINES);
+    fprintf(stderr, "  --finesse      count pieces placed with more keys than needed\n");
+    fprintf(stderr, "  --stats        show renderer and input latency statistics\n");
+    fprintf(stderr, "  --latency FILE write key-to-screen latency histograms to FILE on exit\n");
+    fprintf(stderr, "  --record FILE  save each finished game to FILE\n");
+    fprintf(stderr, "  --versus 1|2   play player 1 or 2 of a match against another instance\n");
+    fprintf(stderr, "  --port N       UDP port of player 1 on localhost; player 2 uses N+1 (default 7341)\n");
+    fprintf(stderr, "  --jitter MS    delay each outgoing versus packet by a random 0..MS ms\n");
+    fprintf(stderr, "  --replay FILE  watch a recorded game at real speed\n");
+    fprintf(stderr, "  --verify FILE  re-simulate recordings and check score and board hash\n");
+}
+
+int main(int argc, char **argv) {
+    int use_bot = 0;
+    const char *replay_path = NULL;
+    BotWeights weights = BOT_DEFAULT_WEIGHTS;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--verify") == 0 && i + 1 < argc) {
+            init_piece_masks();
+            return verify_replays(argc - i - 1, argv + i + 1);
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--latency") == 0 && i + 1 < argc) {
+            latency_path = argv[++i];
+        } else if (strcmp(argv[i], "--pc") == 0 && i + 1 < argc) {
+            pc_lines = atoi(argv[++i]);
+            if (pc_lines < 1 || pc_lines > PC_MAX_LINES) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--finesse") == 0) {
+            show_finesse = 1;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            show_stats = 1;
+        } else if (strcmp(argv[i], "--bot") == 0) {
+            use_bot = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            bot_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--weights") == 0 && i + 1 < argc) {
+            if (!bot_load_weights(&weights, argv[++i])) {
+                fprintf(stderr, "%s: not a valid weights file\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &board_width, &board_height) != 2 ||
+                board_width < 4 || board_width > BOARD_MAX_WIDTH ||
+                board_height < 4 || board_height > BOARD_MAX_HEIGHT) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--versus") == 0 && i + 1 < argc) {
+            versus_player = atoi(argv[++i]);
+            if (versus_player != 1 && versus_player != 2) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            versus_port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--jitter") == 0 && i + 1 < argc) {
+            net_set_jitter((long)(atof(argv[++i]) * 1000));
+        } else if (strcmp(argv[i], "--gravity") == 0 && i + 1 < argc) {
+            double g = atof(argv[++i]);
+            if (g > 0) gravity_override = (long)(1000000 / 60 / g);
+            if (gravity_override < 1) gravity_override = 1;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    init_piece_masks();
+    if (replay_path) {
+        play_replay(replay_path);
+        return 0;
+    }
+    if (versus_player && !net_open(versus_player, versus_port)) return 1;
+    if (use_bot) bot = bot_create(bot_threads, &weights);
+    if (pc_lines && !versus_player) pc_hint = pc_hint_create();
     init_ncurses();
-    
+    if (!bot) precise_keys = input_init();
+
+    if (versus_player) {
+        if (versus_connect()) loop_versus();
+        input_shutdown();
+        endwin();
+        net_close();
+        if (session.state.frame) {
+            printf("Versus: %d frames, %ld rollbacks, depth p50/p99/max %ld/%ld/%ld frames\n",
+                   session.state.frame, rollbacks, hist_percentile(&rollback_depth, 50),
+                   hist_percentile(&rollback_depth, 99), rollback_depth.max);
+            printf("  re-simulation p50/p99/max %.1f/%.1f/%.1f us, %ld stalls, %ld time syncs\n",
+                   hist_percentile(&rollback_us, 50) / 1e3, hist_percentile(&rollback_us, 99) / 1e3,
+                   rollback_us.max / 1e3, stalls, time_syncs);
+            printf("  final boards %016llx %016llx\n",
+                   (unsigned long long)board_hash(&session.state.games[0]),
+                   (unsigned long long)board_hash(&session.state.games[1]));
+        }
+        if (latency_path) write_latency(latency_path);
+        if (bot) bot_destroy(bot);
+        rollback_free(&session);
+        return 0;
+    }
+
     while (1) {
         reset_game();
-        loop_game();
+        long end_time = loop_game();
+        if (record_path) {
+            replay_finish(&recording, &game, end_time);
+            replay_save(&recording, record_path);
+        }
+        if (quit_requested) break;
+        if (bot) continue;
         if (!show_game_over()) break;
     }
 
+    input_shutdown();
     endwin();
+
+    if (latency_path) write_latency(latency_path);
+    if (show_finesse) {
+        printf("Finesse: %d faults in %d pieces, %ld extra keys\n", finesse.faults, finesse.judged, finesse.extra);
+    }
+    if (show_stats) {
+        const ScreenStats *s = &screen_stats;
+        printf("Render: %ld frames, %ld idle, %.1f cells/frame\n", s->frames, s->frames_skipped,
+               s->frames ? (double)s->cells_total / s->frames : 0.0);
+    }
+    if (bot) {
+        printf("Bot: %ld pieces, %.0f placements/s, %.2f ms/piece\n", bot_pieces,
+               bot_think_us ? bot_placements / (bot_think_us / 1e6) : 0.0,
+               bot_pieces ? bot_think_us / 1e3 / bot_pieces : 0.0);
+        for (int d = 1; d <= BOT_MAX_DEPTH; d++) {
+            printf("  depth %d: %ld pieces\n", d, bot_depth_hist[d]);
+        }
+        bot_destroy(bot);
+    }
+    pc_hint_destroy(pc_hint);
+    free_game(&game);
+    replay_free(&recording);
     return 0;
 }
 
+/* Monotonic, so game timing is immune to wall clock adjustments. */
 long get_time_us() {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return (tv.tv_sec * 1000000) + tv.tv_usec;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+/* Nanosecond stopwatch for costs too small for get_time_us(). */
+long get_time_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+/* Sleep until `deadline` or until a key, a versus packet or a perfect
+   clear hint arrives, whichever is first. */
+void wait_until(long deadline) {
+    long wait = deadline - get_time_us();
+    if (wait <= 0) return;
+
+    struct timeval tv = { wait / 1000000, wait % 1000000 };
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(STDIN_FILENO, &fds);
+    int nfds = STDIN_FILENO + 1;
+    if (net_fd() >= 0) {
+        FD_SET(net_fd(), &fds);
+        if (net_fd() >= nfds) nfds = net_fd() + 1;
+    }
+    if (pc_hint) {
+        FD_SET(pc_hint_fd(pc_hint), &fds);
+        if (pc_hint_fd(pc_hint) >= nfds) nfds = pc_hint_fd(pc_hint) + 1;
+    }
+    select(nfds, &fds, NULL, NULL, &tv);
 }
 
 void init_ncurses() {
@@ -163,7 +303,6 @@ void init_ncurses() {
     curs_set(FALSE);
     keypad(stdscr, TRUE);
     nodelay(stdscr, TRUE);
-    srand(time(NULL));
 
     if (has_colors()) {
         start_color();
@@ -175,27 +314,21 @@ void init_ncurses() {
         init_pair(6, COLOR_BLACK, COLOR_MAGENTA);
         init_pair(7, COLOR_BLACK, COLOR_RED);
         init_pair(8, COLOR_WHITE, COLOR_BLACK);
+        init_pair(GARBAGE_COLOR, COLOR_BLACK, COLOR_WHITE);
     }
 }
 
 void reset_game() {
-    memset(board, 0, sizeof(board));
-    score = 0;
-    game_over = 0;
-    drop_rate = DROP_RATE_INITIAL;
-    hold_piece_type = -1;
-    can_hold = 1;
-    lock_timer = 0;
-    
-    shuffle_bag();
-    next_piece_type = next_from_bag();
-    new_piece();
-    last_drop_time = get_time_us();
+    long now = get_time_us();
+    free_game(&game);
+    init_game_size(&game, board_width, board_height, (uint64_t)time(NULL), now);
+    if (gravity_override) game.drop_rate = gravity_override;
+    pc_state = -1;
+    finesse_init(&finesse, &game);
+    if (record_path) replay_start(&recording, &game, now);
 }
 
 int show_game_over() {
-    nodelay(stdscr, FALSE); // Blocking input
-    
     int h = 10, w = 40;
     int y = (LINES - h) / 2;
     int x = (COLS - w) / 2;
@@ -203,478 +336,777 @@ int show_game_over() {
     WINDOW *win = newwin(h, w, y, x);
     box(win, 0, 0);
     mvwprintw(win, 2, (w - 11) / 2, "GAME OVER");
-    mvwprintw(win, 4, (w - 16) / 2, "Final Score: %d", score);
+    mvwprintw(win, 4, (w - 16) / 2, "Final Score: %d", game.score);
     mvwprintw(win, 6, (w - 24) / 2, "Press 'r' to Restart");
     mvwprintw(win, 7, (w - 20) / 2, "Press 'q' to Quit");
     wrefresh(win);
     
-    int ch;
+    KeyEvent ev;
     while (1) {
-        ch = getch();
-        if (ch == 'r' || ch == 'R') {
-            nodelay(stdscr, TRUE);
+        if (!input_poll(&ev)) {
+            wait_until(get_time_us() + 1000000);
+            continue;
+        }
+        if (ev.kind != EV_PRESS) continue;
+        if (ev.ch == 'r' || ev.ch == 'R') {
             delwin(win);
+            screen_invalidate();
             return 1;
         }
-        if (ch == 'q' || ch == 'Q') {
-            nodelay(stdscr, TRUE);
+        if (ev.ch == 'q' || ev.ch == 'Q') {
             delwin(win);
             return 0;
         }
     }
 }
 
-void spawn_piece(int type) {
-    current_piece.type = type;
-    current_piece.x = (BOARD_WIDTH - SHAPES[type].grid_size) / 2;
-    current_piece.y = 0;
-    current_piece.rotation = 0;
-    current_piece.color = SHAPES[type].color;
-    
-    if (check_collision(current_piece.x, current_piece.y, current_piece.rotation)) {
-        game_over = 1;
+void draw_preview(int start_y, int start_x, int type, const char* label) {
+    screen_put(start_y, start_x, label, 0, A_NORMAL);
+    if (type == -1) return;
+
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            if ((piece_masks[type][0].rows[i] >> j) & 1) {
+                screen_put(start_y + 2 + i, start_x + (j * 2), "  ", SHAPES[type].color, A_NORMAL);
+            }
+        }
     }
-    
-    lock_timer = 0; /* Reset lock timer on spawn */
 }
 
-void new_piece() {
-    spawn_piece(next_piece_type);
-    next_piece_type = next_from_bag();
-    can_hold = 1;
+/* --stats overlay from screen row `row` down */
+void draw_stats(int row) {
+    const ScreenStats *s = &screen_stats;
+    screen_printf(row++, 0, 0, A_NORMAL, "Render: %.1f cells/frame  %.1f KB/s  %.0f%% frames idle",
+                  s->cells_per_frame, s->bytes_per_sec / 1024, s->idle_percent);
+    int first = row;
+    for (int i = 0; i < INPUT_COUNT; i++) {
+        if (!latency[i].count) continue;
+        screen_printf(row++, 0, 0, A_NORMAL, "%-10s %5.2f/%5.2f ms", INPUT_NAMES[i],
+                      hist_percentile(&latency[i], 50) / 1e3, hist_percentile(&latency[i], 99) / 1e3);
+    }
+    if (row > first) screen_put(row, 0, "(key latency p50/p99)", 0, A_NORMAL);
 }
 
-void hold_piece() {
-    if (!can_hold) return;
-    
-    if (hold_piece_type == -1) {
-        hold_piece_type = current_piece.type;
-        new_piece();
-    } else {
-        int temp = hold_piece_type;
-        hold_piece_type = current_piece.type;
-        spawn_piece(temp);
+/* Finesse totals and the latest fault on screen row `row` */
+void draw_finesse(int row) {
+    const Finesse *f = &finesse;
+    if (!f->faults) {
+        screen_printf(row, 0, 0, A_NORMAL, "Finesse: %d pieces, no faults", f->judged);
+        return;
     }
-    
-    can_hold = 0;
+    char best[128];
+    finesse_describe(f->fault_best, best, sizeof(best));
+    screen_printf(row, 0, 0, A_NORMAL, "Finesse: %d faults in %d pieces  last: %c %d keys, best %s",
+                  f->faults, f->judged, "IJLOSTZ"[f->fault_piece.type], f->fault_presses, best);
 }
 
-int get_block(int type, int rot, int x, int y) {
-    int size = SHAPES[type].grid_size;
-    if (size == 2) return SHAPES[type].shape[y][x]; 
-    
-    int r = rot % 4;
-    int tx = x, ty = y;
-    
-    for (int i = 0; i < r; i++) {
-        int temp = tx;
-        tx = size - 1 - ty;
-        ty = temp;
+/* Draws one board with its hold and next panels, centered on column
+   `center_x`, and `hint` as an outline if not NULL. */
+void draw_game(const TetrisGame *g, int center_x, int term_h, const Tetromino *hint) {
+    /* Boards taller than the terminal scroll to follow the piece */
+    const Tetromino *p = &g->current;
+    int width = g->board.width, height = g->board.height;
+    int view_h = height < term_h - 2 ? height : term_h - 2;
+    int view_top = 0;
+    if (view_h < 1) view_h = 1;
+    if (height > view_h) {
+        view_top = p->y + 2 - view_h / 2;
+        if (view_top > height - view_h) view_top = height - view_h;
+        if (view_top < 0) view_top = 0;
     }
-    
-    if (tx < 0 || tx >= 4 || ty < 0 || ty >= 4) return 0;
 
-    return SHAPES[type].shape[ty][tx];
-}
+    /* Screen position of board row 0, which may be scrolled off */
+    int start_y = (term_h - view_h) / 2 - view_top;
+    int start_x = center_x - width;
+    int view_y = start_y + view_top;
+
+    /* Panels */
+    draw_preview(view_y, start_x - 12, g->hold_type, "HOLD");
+    draw_preview(view_y, start_x + (width * 2) + 4, g->next_type, "NEXT");
+
+    /* Frame */
+    for (int y = -1; y <= view_h; y++) {
+        screen_put(view_y + y, start_x - 2, "<!", 8, A_NORMAL);
+        screen_put(view_y + y, start_x + (width * 2), "!>", 8, A_NORMAL);
+    }
+    if (view_top + view_h == height) {
+        for (int x = 0; x < width * 2; x+=2) screen_put(view_y + view_h, start_x + x, "==", 8, A_NORMAL);
+    }
 
-int check_collision(int px, int py, int prot) {
-    int size = SHAPES[current_piece.type].grid_size;
-    for (int i = 0; i < size; i++) {
-        for (int j = 0; j < size; j++) {
-            if (get_block(current_piece.type, prot, j, i)) {
-                int bx = px + j;
-                int by = py + i;
-                
-                if (bx < 0 || bx >= BOARD_WIDTH || by >= BOARD_HEIGHT) return 1;
-                if (by >= 0 && board[by][bx]) return 1;
+    /* Board */
+    for (int y = view_top; y < view_top + view_h; y++) {
+        const unsigned char *colors = g->colors + (size_t)y * width;
+        for (int x = 0; x < width; x++) {
+            if (colors[x]) {
+                screen_put(start_y + y, start_x + (x * 2), "  ", colors[x], A_NORMAL);
+            } else {
+                screen_put(start_y + y, start_x + (x * 2), " .", 0, A_NORMAL);
             }
         }
     }
-    return 0;
-}
 
-void lock_piece() {
-    int size = SHAPES[current_piece.type].grid_size;
-    for (int i = 0; i < size; i++) {
-        for (int j = 0; j < size; j++) {
-            if (get_block(current_piece.type, current_piece.rotation, j, i)) {
-                int by = current_piece.y + i;
-                int bx = current_piece.x + j;
-                if (by >= 0 && by < BOARD_HEIGHT && bx >= 0 && bx < BOARD_WIDTH) {
-                    board[by][bx] = current_piece.color;
+    /* Perfect clear hint, under the ghost and the piece */
+    if (hint) {
+        const PieceMask *hm = &piece_masks[hint->type][hint->rotation];
+        for (int i = 0; i < 4; i++) {
+            int draw_y = start_y + hint->y + i;
+            if (draw_y < view_y || draw_y >= view_y + view_h) continue;
+            for (int j = 0; j < 4; j++) {
+                if (hm->rows[i] & ((RowMask)1 << j)) {
+                    screen_put(draw_y, start_x + (hint->x + j) * 2, "[]", hint->color, A_BOLD);
                 }
             }
         }
     }
-    clear_lines();
-    new_piece();
-}
 
-void clear_lines() {
-    int lines_cleared = 0;
-    for (int y = BOARD_HEIGHT - 1; y >= 0; y--) {
-        int full = 1;
-        for (int x = 0; x < BOARD_WIDTH; x++) {
-            if (!board[y][x]) { full = 0; break; }
-        }
-        if (full) {
-            lines_cleared++;
-            for (int k = y; k > 0; k--) {
-                for (int x = 0; x < BOARD_WIDTH; x++) board[k][x] = board[k-1][x];
+    /* Ghost Piece */
+    const PieceMask *m = &piece_masks[p->type][p->rotation];
+    int drop_y = ghost_y(g);
+    
+    /* Draw Ghost */
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            if (m->rows[i] & ((RowMask)1 << j)) {
+                int draw_y = start_y + drop_y + i;
+                int draw_x = start_x + (p->x + j) * 2;
+                if (draw_y >= view_y && draw_y < view_y + view_h) {
+                    screen_put(draw_y, draw_x, "::", p->color, A_DIM);
+                }
             }
-            for (int x = 0; x < BOARD_WIDTH; x++) board[0][x] = 0;
-            y++;
         }
     }
-    if (lines_cleared > 0) {
-        /* Award points based on lines cleared */
-        switch (lines_cleared) {
-            case 1: score += 100; break;
-            case 2: score += 300; break;
-            case 3: score += 500; break;
-            case 4: score += 800; break;
-        }
-        
-        /* Check for all-clear (perfect clear) bonus */
-        int board_empty = 1;
-        for (int y = 0; y < BOARD_HEIGHT && board_empty; y++) {
-            for (int x = 0; x < BOARD_WIDTH; x++) {
-                if (board[y][x]) {
-                    board_empty = 0;
-                    break;
+
+    /* Draw Active Piece */
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            if (m->rows[i] & ((RowMask)1 << j)) {
+                int draw_y = start_y + p->y + i;
+                int draw_x = start_x + (p->x + j) * 2;
+                if (draw_y >= view_y && draw_y < view_y + view_h) {
+                    screen_put(draw_y, draw_x, "  ", p->color, A_NORMAL);
                 }
             }
         }
-        if (board_empty) {
-            score += 3000; /* All-clear bonus! */
-        }
-        
-        if (drop_rate > 100000) drop_rate -= 10000;
     }
 }
 
-void reset_lock_timer_if_grounded(long now) {
-    if (check_collision(current_piece.x, current_piece.y + 1, current_piece.rotation)) {
-        lock_timer = now; /* Move reset */
+/* Composes the whole frame; the renderer only sends what changed. */
+void draw_board() {
+    int term_h, term_w;
+    getmaxyx(stdscr, term_h, term_w);
+    screen_begin(term_h, term_w);
+    int pc_shown = pc_hint && pc_last.status == PC_FOUND;
+    draw_game(&game, term_w / 2, term_h, pc_shown ? &pc_last.target : NULL);
+
+    screen_printf(0, 0, 0, A_NORMAL, "Score: %d", game.score);
+    if (status_line) {
+        screen_put(1, 0, status_line, 0, A_NORMAL);
+    } else if (bot) {
+        double rate = bot_last.elapsed_us ? bot_last.placements / (bot_last.elapsed_us / 1e6) : 0;
+        screen_printf(1, 0, 0, A_NORMAL, "Bot: depth %d  %.0fk placements/s  %.1f ms/piece",
+                      bot_last.depth, rate / 1000, bot_last.elapsed_us / 1e3);
     }
+    int row = 2;
+    if (pc_shown) {
+        screen_printf(row++, 0, 0, A_NORMAL, "Perfect clear: %d pieces, %d lines%s", pc_last.pieces,
+                      pc_last.lines, pc_last.use_hold ? " (hold first)" : "");
+    }
+    if (show_finesse) draw_finesse(row++);
+    if (show_stats) draw_stats(row);
+    screen_flush();
 }
 
-void move_piece(int dx, int dy) {
-    if (!check_collision(current_piece.x + dx, current_piece.y + dy, current_piece.rotation)) {
-        current_piece.x += dx;
-        current_piece.y += dy;
-        /* Logic: If we moved successfully, and we are ON GROUND, reset timer */
-        /* Exception: Soft drop (dy=1). Usually soft drop DOES NOT reset timer endlessly, 
-           but for simplicity here we might allow it or just ignore. 
-           Let's apply reset only for lateral moves (dx!=0) to prevent stalling by dropping?
-           Standard Tetris rules say ANY successful movement resets step counter (limited times).
-           We will impl infinite reset for simplicity.
-        */
-        if (dx != 0) {
-           reset_lock_timer_if_grounded(get_time_us()); 
-        }
+#define INPUT_KEEPALIVE 70000  /* 70ms: Strict for clear release detection */
+#define ARR_DELAY 45000        /* 45ms: Slower speed (User req "too fast") */
+#define DAS_DELAY 90000        /* 90ms: Snappy start (User req "too long") */
+#define SDF_DELAY 70000        /* 70ms: ~15Hz Standard Soft Drop (Controllable) */
+
+#define DAS_KEEP 300000        /* 300ms: re-press within this keeps ARR speed */
+
+/* Input State: most terminals only report key presses and their
+   auto-repeats, so a key counts as held until INPUT_KEEPALIVE passes
+   without one. With precise_keys the terminal reports releases and `held`
+   is exact. Our own DAS/ARR/SDF repeats run off absolute deadlines while
+   a key is held. */
+
+typedef struct {
+    int input;
+    int held;           /* pressed and not released, precise_keys only */
+    long last_key;      /* last time the key was seen */
+    long next_repeat;   /* deadline of the next repeat */
+    int charged;        /* DAS has elapsed, repeats are at ARR speed */
+} KeyRepeat;
+
+enum { REPEAT_LEFT, REPEAT_RIGHT, REPEAT_DOWN, REPEAT_COUNT };
+KeyRepeat repeats[REPEAT_COUNT] = {
+    { INPUT_LEFT, 0, 0, 0, 0 }, { INPUT_RIGHT, 0, 0, 0, 0 }, { INPUT_SOFT_DROP, 0, 0, 0, 0 }
+};
+
+
+/* Every input goes through here so it can be recorded. Returns 1 if the
+   game state changed. */
+int play_input(int input, long now) {
+    if (versus_player) {
+        /* Lands in the next frame sent */
+        versus_mask |= 1 << input;
+        return 1;
     }
+    if (record_path) replay_record(&recording, input, now);
+    int changed = apply_input(&game, input, now);
+    finesse_input(&finesse, &game, input);
+    return changed;
 }
 
-void rotate_piece(int dir) {
-    int old_rot = current_piece.rotation;
-    int new_rot = (old_rot + 4 + dir) % 4;
-    int kick_idx = get_kick_index(old_rot, new_rot);
-    int (*kicks)[2] = NULL;
-    
-    /* Type 0 = I, Type 3 = O, Others = JLSTZ */
-    if (current_piece.type == 0) {
-        kicks = (int (*)[2])KICKS_I[kick_idx];
-    } else if (current_piece.type == 3) {
-        /* O piece rotates but no kicks */
-        kicks = NULL;
-    } else {
-        kicks = (int (*)[2])KICKS_JLSTZ[kick_idx];
+/* An input straight from a key read at `key_time`. If it changed the
+   game, its latency is taken once the frame showing it is out. */
+void key_input(int input, long now, long key_time) {
+    if (play_input(input, now) && pending_keys < MAX_PENDING_KEYS) {
+        pending_input[pending_keys] = input;
+        pending_time[pending_keys] = key_time;
+        pending_keys++;
     }
-    
-    int rotated = 0;
-    
-    /* Basic Rotation + 5 SRS Tests */
-    for (int i = 0; i < 5; i++) {
-        int dx = 0, dy = 0;
-        if (kicks) {
-            dx = kicks[i][0];
-            dy = kicks[i][1];
-        } else {
-            /* If no kicks (O piece), only test 0 */
-            if (i > 0) break;
+}
+
+/* Called once the first `count` pending keys are on screen. */
+void report_latency(int count) {
+    long t = get_time_us();
+    for (int i = 0; i < count; i++) {
+        hist_record(&latency[pending_input[i]], t - pending_time[i]);
+    }
+    pending_keys -= count;
+    memmove(pending_input, pending_input + count, sizeof(int) * pending_keys);
+    memmove(pending_time, pending_time + count, sizeof(long) * pending_keys);
+}
+
+void write_latency(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "%s: cannot write latency histograms\n", path);
+        return;
+    }
+    fprintf(f, "# Key-to-screen latency in milliseconds, from getch() to refresh()\n");
+    for (int i = 0; i < INPUT_COUNT; i++) {
+        if (!latency[i].count) continue;
+        fprintf(f, "\n# %s\n", INPUT_NAMES[i]);
+        hist_write(&latency[i], f, 1e3);
+    }
+    fclose(f);
+}
+
+/* Ask for a new perfect clear search whenever a piece spawns or is held,
+   and pick up the result when it is ready. Never waits. */
+void update_pc_hint() {
+    long state = (long)game.pieces << 8 | (game.hold_type + 1) << 4 | game.current.type << 1 | game.can_hold;
+    if (state != pc_state) {
+        pc_state = state;
+        pc_last.status = PC_NONE;
+        if (!game.game_over) pc_hint_start(pc_hint, &game, pc_lines, PC_BUDGET_US);
+    }
+    pc_hint_poll(pc_hint, &pc_last);
+}
+
+/* One bot decision per spawned piece, played out within the same tick so
+   it keeps up at any gravity. */
+void bot_turn(long now) {
+    BotMove move;
+    unsigned char inputs[BOT_MAX_INPUTS];
+    if (!bot_think(bot, &game, BOT_BUDGET_US, &move, &bot_last)) return;
+    int n = bot_inputs(&move, &game, inputs, BOT_MAX_INPUTS);
+    for (int i = 0; i < n; i++) play_input(inputs[i], now);
+
+    bot_pieces++;
+    bot_placements += bot_last.placements;
+    bot_think_us += bot_last.elapsed_us;
+    bot_depth_hist[bot_last.depth]++;
+}
+
+KeyRepeat *repeat_for_key(int ch) {
+    switch (ch) {
+        case 'a': case 'A': case KEY_LEFT: return &repeats[REPEAT_LEFT];
+        case 'd': case 'D': case KEY_RIGHT: return &repeats[REPEAT_RIGHT];
+        case 's': case 'S': case KEY_DOWN: return &repeats[REPEAT_DOWN];
+    }
+    return NULL;
+}
+
+void press_repeat(KeyRepeat *k, long now, long key_time) {
+    if (precise_keys) {
+        if (!k->held) {
+            key_input(k->input, now, key_time);
+            k->held = 1;
+            k->next_repeat = now + (k->input == INPUT_SOFT_DROP ? SDF_DELAY : DAS_DELAY);
         }
-        
-        if (!check_collision(current_piece.x + dx, current_piece.y + dy, new_rot)) {
-            current_piece.x += dx;
-            current_piece.y += dy;
-            current_piece.rotation = new_rot;
-            rotated = 1;
-            break;
+        return;
+    }
+
+    if (now - k->last_key > INPUT_KEEPALIVE) {
+        /* New Press or Resume */
+        key_input(k->input, now, key_time);
+
+        if (k->input == INPUT_SOFT_DROP) {
+            k->next_repeat = now + SDF_DELAY;
+        } else if (now - k->last_key < DAS_KEEP && k->charged) {
+            /* DAS Preservation: quick re-press keeps momentum */
+            k->next_repeat = now + ARR_DELAY;
+        } else {
+            k->next_repeat = now + DAS_DELAY;
+            k->charged = 0;
         }
     }
-    
-    if (rotated) {
-        reset_lock_timer_if_grounded(get_time_us());
+    k->last_key = now;
+}
+
+/* The held key whose repeat is due first, or NULL. Ties go to the lower
+   index so catch-up order never depends on timing. */
+KeyRepeat *next_repeat() {
+    KeyRepeat *first = NULL;
+    for (int i = 0; i < REPEAT_COUNT; i++) {
+        KeyRepeat *k = &repeats[i];
+        if (precise_keys ? !k->held : k->next_repeat - k->last_key >= INPUT_KEEPALIVE) continue;
+        if (!first || k->next_repeat < first->next_repeat) first = k;
     }
+    return first;
 }
 
-void hard_drop() {
-    while (!check_collision(current_piece.x, current_piece.y + 1, current_piece.rotation)) {
-        current_piece.y++;
+/* Fire every repeat and game deadline up to `now`, each at its own due
+   time and in time order, the same order a replay re-applies them in. */
+void run_deadlines(long now) {
+    KeyRepeat *k;
+    while (!game.game_over && (k = next_repeat()) && k->next_repeat <= now) {
+        long t = k->next_repeat;
+        update_game(&game, t);
+        if (game.game_over) break;
+        play_input(k->input, t);
+        k->charged = 1;
+        k->next_repeat += k->input == INPUT_SOFT_DROP ? SDF_DELAY : ARR_DELAY;
     }
-    lock_piece();
-    last_drop_time = get_time_us();
+    update_game(&game, now);
 }
 
-void draw_preview(int start_y, int start_x, int type, const char* label) {
-    mvprintw(start_y, start_x, "%s", label);
-    
-    /* Always clear/draw 4x4 area to ensure previous piece is erased */
-    for(int i=0; i<4; i++) {
-        for(int j=0; j<4; j++) {
-            /* If type is -1 (empty), just clear the space */
-            int is_block = 0;
-            if (type != -1) {
-                attron(COLOR_PAIR(SHAPES[type].color));
-                is_block = get_block(type, 0, j, i);
-            }
-            
-            if (is_block) {
-                mvprintw(start_y + 2 + i, start_x + (j * 2), "  ");
-            } else {
-                /* Clear the space if it was previously occupied or is empty */
-                /* Use default color pair or turn off attributes */
-                attroff(COLOR_PAIR(1)|COLOR_PAIR(2)|COLOR_PAIR(3)|COLOR_PAIR(4)|COLOR_PAIR(5)|COLOR_PAIR(6)|COLOR_PAIR(7)); 
-                /* Accessing global pairs blindly is risky if not careful, but safely we can just use stdscr default */
-                /* Safer: turn off the specific color if we set it, but we can just use 0 */
-                attrset(A_NORMAL);
-                mvprintw(start_y + 2 + i, start_x + (j * 2), "  ");
+void reset_repeats(long now) {
+    for (int i = 0; i < REPEAT_COUNT; i++) {
+        repeats[i].held = 0;
+        repeats[i].last_key = now - INPUT_KEEPALIVE;   /* released */
+        repeats[i].next_repeat = now;
+        repeats[i].charged = 0;
+    }
+}
+
+/* Turn one key event into inputs. Returns 0 for the quit key. */
+int handle_key(const KeyEvent *ev, long now) {
+    long key_time = get_time_us();
+    KeyRepeat *k = repeat_for_key(ev->ch);
+    if (ev->kind == EV_REPEAT) return 1;    /* we repeat on our own clock */
+    if (ev->kind == EV_RELEASE) {
+        if (k) k->held = 0;
+        return 1;
+    }
+    if (k) {
+        press_repeat(k, now, key_time);
+        return 1;
+    }
+    switch (ev->ch) {
+        /* Single Action Keys */
+        case 'j':
+        case 'J': key_input(INPUT_ROTATE_CCW, now, key_time); break;
+        case 'k':
+        case 'K': key_input(INPUT_ROTATE_CW, now, key_time); break;
+        case ' ': key_input(INPUT_HARD_DROP, now, key_time); break;
+        case 'c':
+        case 'C':
+        case 'h':
+        case 'H': key_input(INPUT_HOLD, now, key_time); break;
+        case KEY_UP: key_input(INPUT_ROTATE_CW, now, key_time); break; 
+        case 'q': return 0;
+    }
+    return 1;
+}
+
+/* Runs until the game ends; returns the time of the last tick. */
+long loop_game() {
+    long now = get_time_us();
+    reset_repeats(now);
+
+    while (!game.game_over) {
+        now = get_time_us();
+        run_deadlines(now);
+        finesse_sync(&finesse, &game);
+
+        /* Input Handling - Process all pending keys */
+        int ch;
+        while (bot && (ch = getch()) != ERR) {
+            if (ch == 'q' || ch == 'Q') {
+                quit_requested = 1;
+                game.game_over = 1;
             }
-            
-            if (type != -1) attroff(COLOR_PAIR(SHAPES[type].color));
         }
+        KeyEvent ev;
+        while (!bot && input_poll(&ev)) {
+            if (!handle_key(&ev, now)) game.game_over = 1;
+        }
+
+        if (bot && !game.game_over) bot_turn(now);
+        if (pc_hint) update_pc_hint();
+
+        draw_board();
+        report_latency(pending_keys);
+
+        /* Sleep until something is due: a key repeat, gravity or lock
+           delay, or a new key. The bot moves every frame instead. */
+        long deadline = next_deadline(&game);
+        KeyRepeat *k = next_repeat();
+        if (k && k->next_repeat < deadline) deadline = k->next_repeat;
+        if (bot && now + DELAY < deadline) deadline = now + DELAY;
+        wait_until(deadline);
     }
+    return now;
 }
 
-void draw_board() {
-    /* Remove global clear() to prevent flickering. 
-       Only clear if terminal size changes. */
-    static int prev_term_w = -1, prev_term_h = -1;
-    int term_h, term_w;
-    getmaxyx(stdscr, term_h, term_w);
-    
-    if (term_w != prev_term_w || term_h != prev_term_h) {
-        prev_term_w = term_w;
-        prev_term_h = term_h;
-        clear();
+/* Watch a recording at the speed it was played, on the real clock. */
+void play_replay(const char *path) {
+    Replay r;
+    if (!replay_load(&r, path)) {
+        fprintf(stderr, "%s: not a valid replay\n", path);
+        return;
     }
-    
-    int start_y = (term_h - BOARD_HEIGHT) / 2;
-    int start_x = (term_w - (BOARD_WIDTH * 2)) / 2;
 
-    /* Panels */
-    draw_preview(start_y, start_x - 12, hold_piece_type, "HOLD");
-    draw_preview(start_y, start_x + (BOARD_WIDTH * 2) + 4, next_piece_type, "NEXT");
+    init_ncurses();
+    replay_init_game(&r, &game);
+    finesse_init(&finesse, &game);
+    show_finesse = 1;
+    status_line = "REPLAY  (q to stop)";
 
-    /* Frame */
-    attron(COLOR_PAIR(8));
-    for (int y = -1; y <= BOARD_HEIGHT; y++) {
-        mvprintw(start_y + y, start_x - 2, "<!");
-        mvprintw(start_y + y, start_x + (BOARD_WIDTH * 2), "!>");
+    ReplayCursor cursor = { 0, 0, 0 };
+    int input, more;
+    long event_time;
+    long start = get_time_us();
+    more = replay_next(&r, &cursor, &input, &event_time);
+
+    while (1) {
+        long t = get_time_us() - start;
+        while (more && event_time <= t) {
+            update_game(&game, event_time);
+            apply_input(&game, input, event_time);
+            finesse_input(&finesse, &game, input);
+            more = replay_next(&r, &cursor, &input, &event_time);
+        }
+        if (!more && event_time <= t) break;
+        update_game(&game, t);
+        finesse_sync(&finesse, &game);
+
+        int ch = getch();
+        if (ch == 'q' || ch == 'Q') break;
+
+        draw_board();
+
+        long deadline = next_deadline(&game);
+        if (more && event_time < deadline) deadline = event_time;
+        if (deadline > t + DELAY) deadline = t + DELAY;
+        wait_until(start + deadline);
     }
-    for (int x = 0; x < BOARD_WIDTH * 2; x+=2) mvprintw(start_y + BOARD_HEIGHT, start_x + x, "==");
-    attroff(COLOR_PAIR(8));
+    if (!more) update_game(&game, event_time);
+    draw_board();
+    endwin();
 
-    /* Board */
-    for (int y = 0; y < BOARD_HEIGHT; y++) {
-        for (int x = 0; x < BOARD_WIDTH; x++) {
-            if (board[y][x]) {
-                attron(COLOR_PAIR(board[y][x]));
-                mvprintw(start_y + y, start_x + (x * 2), "  ");
-                attroff(COLOR_PAIR(board[y][x]));
-            } else {
-                /* Explicitly draw background to erase previous active pieces */
-                attrset(A_NORMAL);
-                mvprintw(start_y + y, start_x + (x * 2), " .");
-            }
+    int match = !more && game.score == r.score && board_hash(&game) == r.hash;
+    finesse_sync(&finesse, &game);
+    printf("%s: score %d, lines %d, %s\n", path, game.score, game.lines,
+           more ? "stopped early" : match ? "matches recording" : "MISMATCH");
+    printf("  finesse: %d faults in %d pieces, %ld extra keys\n",
+           finesse.faults, finesse.judged, finesse.extra);
+    free_game(&game);
+    replay_free(&r);
+}
+
+/* Re-simulate recordings without rendering or waiting, for bulk audits.
+   Returns the process exit status. */
+int verify_replays(int count, char **paths) {
+    int failed = 0;
+    long events = 0, game_us = 0;
+    long start = get_time_us();
+
+    for (int i = 0; i < count; i++) {
+        Replay r;
+        if (!replay_load(&r, paths[i])) {
+            printf("%s: unreadable\n", paths[i]);
+            failed++;
+            continue;
         }
+
+        TetrisGame g;
+        Finesse f;
+        ReplayCursor end;
+        int ok = replay_verify(&r, &g, &f, &end);
+        free_game(&g);
+        printf("%s: score %d lines %d pieces %d hash %016llx %s, %d finesse faults\n", paths[i],
+               r.score, r.lines, r.pieces, (unsigned long long)r.hash,
+               ok ? "OK" : "MISMATCH", f.faults);
+        if (!ok) failed++;
+
+        events += end.events;
+        game_us += end.time;
+        replay_free(&r);
     }
 
-    /* Ghost Piece */
-    int ghost_y = current_piece.y;
-    while (!check_collision(current_piece.x, ghost_y + 1, current_piece.rotation)) {
-        ghost_y++;
+    double elapsed = (get_time_us() - start) / 1e6;
+    printf("%d replays, %d failed, %ld events, %.1f game-seconds in %.3fs\n",
+           count, failed, events, game_us / 1e6, elapsed);
+    return failed ? 1 : 0;
+}
+
+/* --- Versus --- */
+
+void send_hello(long now) {
+    Packet p;
+    memset(&p, 0, sizeof(p));
+    p.type = PACKET_HELLO;
+    p.seed = versus_seed;
+    p.width = board_width;
+    p.height = board_height;
+    net_send(&p, now);
+}
+
+/* Everything the peer has not acknowledged, so no single packet matters. */
+void send_inputs(long now) {
+    Packet p;
+    p.type = PACKET_INPUTS;
+    p.ack = session.remote_next;
+    p.frame = session.state.frame;
+    p.advantage = session.state.frame - peer_frame;
+    p.first = session.remote_ack;
+    p.count = session.local_next - p.first;
+    for (int i = 0; i < p.count; i++) {
+        p.masks[i] = session.inputs[session.local][VERSUS_SLOT(p.first + i)];
     }
-    
-    /* Draw Ghost */
-    attron(COLOR_PAIR(current_piece.color) | A_DIM);
-    for (int i = 0; i < 4; i++) {
-        for (int j = 0; j < 4; j++) {
-            if (get_block(current_piece.type, current_piece.rotation, j, i)) {
-                int draw_y = start_y + ghost_y + i;
-                int draw_x = start_x + (current_piece.x + j) * 2;
-                if (draw_y >= start_y && draw_y < start_y + BOARD_HEIGHT) {
-                    mvprintw(draw_y, draw_x, "::"); 
-                }
+    net_send(&p, now);
+}
+
+/* Agree on the seed and board size with the other instance; player 1
+   picks them. Returns 0 if the user quit while waiting. */
+int versus_connect() {
+    char waiting[80];
+    snprintf(waiting, sizeof(waiting), "Waiting for player %d on port %d  (q to quit)",
+             3 - versus_player, versus_port + (versus_player == 1 ? 1 : 0));
+    versus_seed = (uint64_t)time(NULL) ^ ((uint64_t)getpid() << 32);
+    long next_hello = 0;
+
+    while (1) {
+        long now = get_time_us();
+        net_flush(now);
+
+        Packet p;
+        while (net_recv(&p)) {
+            /* Player 1 starts on any sign of player 2: the reply to its
+               hello, or inputs if the reply was lost */
+            if (versus_player == 1 && p.type != PACKET_QUIT) return 1;
+            if (versus_player == 2 && p.type == PACKET_HELLO &&
+                p.width >= 4 && p.width <= BOARD_MAX_WIDTH &&
+                p.height >= 4 && p.height <= BOARD_MAX_HEIGHT) {
+                versus_seed = p.seed;
+                board_width = p.width;
+                board_height = p.height;
+                send_hello(now);
+                return 1;
             }
         }
+        if (versus_player == 1 && now >= next_hello) {
+            send_hello(now);
+            next_hello = now + 100000;
+        }
+
+        KeyEvent ev;
+        while (input_poll(&ev)) {
+            if (ev.kind == EV_PRESS && (ev.ch == 'q' || ev.ch == 'Q')) return 0;
+        }
+
+        int term_h, term_w;
+        getmaxyx(stdscr, term_h, term_w);
+        screen_begin(term_h, term_w);
+        screen_put(term_h / 2, (term_w - (int)strlen(waiting)) / 2, waiting, 0, A_NORMAL);
+        screen_flush();
+
+        long deadline = now + 100000;
+        if (versus_player == 1 && next_hello < deadline) deadline = next_hello;
+        if (net_next_send() < deadline) deadline = net_next_send();
+        wait_until(deadline);
     }
-    attroff(COLOR_PAIR(current_piece.color) | A_DIM);
+}
 
-    /* Draw Active Piece */
-    attron(COLOR_PAIR(current_piece.color));
-    for (int i = 0; i < 4; i++) {
-        for (int j = 0; j < 4; j++) {
-            if (get_block(current_piece.type, current_piece.rotation, j, i)) {
-                int draw_y = start_y + current_piece.y + i;
-                int draw_x = start_x + (current_piece.x + j) * 2;
-                if (draw_y >= start_y && draw_y < start_y + BOARD_HEIGHT) {
-                    mvprintw(draw_y, draw_x, "  ");
-                }
+/* Returns 0 once the peer has quit. */
+int receive_packets(long now) {
+    int alive = 1;
+    Packet p;
+    while (net_recv(&p)) {
+        if (p.type == PACKET_QUIT) {
+            alive = 0;
+        } else if (p.type == PACKET_HELLO) {
+            /* Player 1 missed our reply */
+            if (versus_player == 2) send_hello(now);
+        } else {
+            for (int i = 0; i < p.count; i++) rollback_add_remote(&session, p.first + i, p.masks[i]);
+            rollback_ack(&session, p.ack);
+            if (p.frame > peer_frame) {
+                peer_frame = p.frame;
+                peer_advantage = p.advantage;
             }
         }
     }
-    attroff(COLOR_PAIR(current_piece.color));
+    return alive;
+}
+
+/* Plan a move whenever our piece changes, then feed it in one input per
+   frame. Plans are made on the predicted state; a rollback that changes
+   the board just makes the bot play worse. */
+void versus_bot_turn() {
+    const TetrisGame *g = &session.state.games[session.local];
+    if (bot_queue_pos == bot_queue_len && g->pieces != bot_planned) {
+        BotMove move;
+        if (!bot_think(bot, g, BOT_BUDGET_US, &move, &bot_last)) return;
+        bot_queue_len = bot_inputs(&move, g, bot_queue, BOT_MAX_INPUTS);
+        bot_queue_pos = 0;
+        bot_planned = g->pieces;
 
-    attrset(A_NORMAL);
-    mvprintw(0, 0, "Score: %d          ", score); /* Padding to clear long scores */
-    refresh();
+        bot_pieces++;
+        bot_placements += bot_last.placements;
+        bot_think_us += bot_last.elapsed_us;
+        bot_depth_hist[bot_last.depth]++;
+    }
+    if (bot_queue_pos < bot_queue_len) versus_mask |= 1 << bot_queue[bot_queue_pos++];
 }
 
-#define INPUT_KEEPALIVE 70000  /* 70ms: Strict for clear release detection */
-#define ARR_DELAY 45000        /* 45ms: Slower speed (User req "too fast") */
-#define DAS_DELAY 90000        /* 90ms: Snappy start (User req "too long") */
-#define SDF_DELAY 70000        /* 70ms: ~15Hz Standard Soft Drop (Controllable) */
+/* One tick of the frame clock: commit the local inputs and simulate the
+   present frame, unless that would outrun the window or the peer. */
+void versus_tick(long now, int *last_sync) {
+    Rollback *s = &session;
+    int frame = s->state.frame;
 
-/* Input State */
-long t_last_left = 0, t_last_right = 0, t_last_down = 0;
-long acc_left = 0, acc_right = 0, acc_down = 0;
+    /* Each side sees the other's frame late by the same latency, so half
+       the difference of the two advantages is how far ahead we are.
+       Wait a frame now and then to let a slower peer catch up. */
+    int ahead = ((frame - peer_frame) - peer_advantage) / 2;
+    if (!rollback_can_advance(s)) {
+        stalls++;
+    } else if (ahead >= 1 && frame % 8 == 0 && *last_sync != frame) {
+        *last_sync = frame;
+        time_syncs++;
+    } else {
+        if (bot) versus_bot_turn();
+        rollback_add_local(s, versus_mask);
+        versus_mask = 0;
+        if (pending_keys > committed_keys) {
+            committed_keys = pending_keys;
+            pending_frame = s->local_next - 1;
+        }
+        rollback_advance(s);
+    }
+    send_inputs(now);
+}
 
+void draw_versus(const char *result) {
+    int term_h, term_w;
+    getmaxyx(stdscr, term_h, term_w);
+    screen_begin(term_h, term_w);
 
+    for (int side = 0; side < 2; side++) {
+        int p = side == 0 ? session.local : 1 - session.local;
+        const TetrisGame *g = &session.state.games[p];
+        int center = side == 0 ? term_w / 4 : term_w * 3 / 4;
+        draw_game(g, center, term_h, NULL);
+        screen_printf(0, center - 14, 0, A_NORMAL, "%-8s Score: %-6d Garbage: %d",
+                      side == 0 ? "YOU" : "OPPONENT", g->score, session.state.incoming[p]);
+    }
+    screen_printf(1, 0, 0, A_NORMAL, "Frame %d  predicted %d  rollbacks %ld (p99 %ld frames, %.1f us)  stalls %ld",
+                  session.state.frame, session.state.frame - session.remote_next, rollbacks,
+                  hist_percentile(&rollback_depth, 99), hist_percentile(&rollback_us, 99) / 1e3, stalls);
+    if (show_stats) draw_stats(2);
 
-void loop_game() {
-    while (!game_over) {
-        long now = get_time_us();
-        
-        /* Input Handling - Process all pending keys */
-        int ch;
-        while ((ch = getch()) != ERR) {
-            switch (ch) {
-                /* Handled by Sticky Logic */
-                case 'a':
-                case 'A': 
-                case KEY_LEFT:
-                    if (now - t_last_left > INPUT_KEEPALIVE) {
-                        /* New Press or Resume */
-                        move_piece(-1, 0); 
-                        
-                        /* DAS Preservation: If gap is short and we were already speeding, don't reset */
-                        if (now - t_last_left < 300000 && acc_left > 0) {
-                            /* Keep momentum */
-                        } else {
-                            acc_left = -DAS_DELAY;
-                        }
-                    }
-                    t_last_left = now; 
-                    break;
-                    
-                case 'd':
-                case 'D': 
-                case KEY_RIGHT:
-                    if (now - t_last_right > INPUT_KEEPALIVE) {
-                        /* New Press or Resume */
-                        move_piece(1, 0); 
-                        
-                        /* DAS Preservation: If gap is short and we were already speeding, don't reset */
-                        if (now - t_last_right < 300000 && acc_right > 0) {
-                             /* Keep momentum */
-                        } else {
-                            acc_right = -DAS_DELAY;
-                        }
-                    }
-                    t_last_right = now; 
-                    break;
-                    
-
-                case 's':
-                case 'S': 
-                case KEY_DOWN:
-                    if (now - t_last_down > INPUT_KEEPALIVE) {
-                        /* New Press */
-                        move_piece(0, 1);
-                        /* acc_down = 0 ? Actually we want it to start dropping if held */
-                        acc_down = 0;
-                    }
-                    t_last_down = now; 
-                    break;
-
-                /* Single Action Keys */
-                case 'j':
-                case 'J': rotate_piece(-1); break;
-                case 'k':
-                case 'K': rotate_piece(1); break;
-                case ' ': hard_drop(); break;
-                case 'c':
-                case 'C':
-                case 'h':
-                case 'H': hold_piece(); break;
-                case KEY_UP: rotate_piece(1); break; 
-                case 'q': game_over = 1; break;
-            }
+    if (result) {
+        screen_put(term_h / 2, (term_w - (int)strlen(result)) / 2, result, 0, A_BOLD);
+        screen_put(term_h / 2 + 1, (term_w - 11) / 2, "q to leave", 0, A_NORMAL);
+    }
+    screen_flush();
+}
+
+/* Play one match, ticking at VERSUS_HZ on the real clock. Returns when
+   either player quits; a decided match stays on screen until then. */
+void loop_versus() {
+    long now = get_time_us();
+    rollback_init(&session, versus_player - 1, versus_seed, board_width, board_height);
+    reset_repeats(now);
+
+    long next_tick = now;
+    int last_sync = -1, peer_alive = 1;
+    const char *result = NULL;
+
+    while (1) {
+        now = get_time_us();
+        net_flush(now);
+        if (!receive_packets(now)) peer_alive = 0;
+
+        long t0 = get_time_ns();
+        int depth = rollback_sync(&session);
+        if (depth) {
+            hist_record(&rollback_depth, depth);
+            hist_record(&rollback_us, get_time_ns() - t0);
+            rollbacks++;
         }
 
-        /* Sticky / ARR Logic */
-        /* Left */
-        if (now - t_last_left < INPUT_KEEPALIVE) {
-            acc_left += DELAY;
-            while (acc_left >= ARR_DELAY) {
-                move_piece(-1, 0);
-                acc_left -= ARR_DELAY;
+        KeyEvent ev;
+        int quit = 0;
+        while (input_poll(&ev)) {
+            if (bot) {
+                if (ev.ch == 'q' || ev.ch == 'Q') quit = 1;
+            } else if (!handle_key(&ev, now)) {
+                quit = 1;
             }
         }
-        /* Right */
-        if (now - t_last_right < INPUT_KEEPALIVE) {
-            acc_right += DELAY;
-            while (acc_right >= ARR_DELAY) {
-                move_piece(1, 0);
-                acc_right -= ARR_DELAY;
-            }
+        if (quit) break;
+
+        /* Our own repeats only need frame precision here */
+        KeyRepeat *k;
+        while ((k = next_repeat()) && k->next_repeat <= now) {
+            play_input(k->input, k->next_repeat);
+            k->charged = 1;
+            k->next_repeat += k->input == INPUT_SOFT_DROP ? SDF_DELAY : ARR_DELAY;
         }
-        /* Soft Drop */
-        if (now - t_last_down < INPUT_KEEPALIVE) {
-            acc_down += DELAY;
-            while (acc_down >= SDF_DELAY) {
-                move_piece(0, 1);
-                acc_down -= SDF_DELAY;
-            }
+
+        /* Decided once the frame that ended it is confirmed */
+        int winner = versus_winner(&session.state);
+        if (!result && winner != -1 && session.remote_next >= session.state.frame) {
+            result = winner == 2 ? "DRAW" : winner == session.local ? "YOU WIN" : "YOU LOSE";
         }
+        if (!result && !peer_alive) result = "OPPONENT LEFT";
 
-        /* Check Grounded State & Lock Delay */
-        int grounded = check_collision(current_piece.x, current_piece.y + 1, current_piece.rotation);
-        
-        if (grounded) {
-            if (lock_timer == 0) {
-                lock_timer = now;
-            }
-            if (now - lock_timer > LOCK_DELAY) {
-                lock_piece();
-                grounded = 0;
-                lock_timer = 0;
+        /* A few late frames are caught up; after a longer hiccup the
+           clock restarts and the peer's time sync absorbs the gap */
+        if (now - next_tick > 8 * VERSUS_FRAME_US) next_tick = now;
+        while (now >= next_tick) {
+            if (result) {
+                /* Keep answering so the peer can confirm the result too */
+                next_tick = now + 50000;
+                if (peer_alive) send_inputs(now);
+                break;
             }
-        } else {
-            lock_timer = 0;
+            next_tick += VERSUS_FRAME_US;
+            versus_tick(now, &last_sync);
         }
-        
-        /* Gravity Logic */
-        if (now - last_drop_time > drop_rate) {
-            if (!grounded) {
-                current_piece.y++;
-            }
-            last_drop_time = now;
+
+        draw_versus(result);
+        if (pending_frame >= 0 && session.state.frame > pending_frame) {
+            report_latency(committed_keys);
+            committed_keys = 0;
+            pending_frame = -1;
         }
 
-        draw_board();
-        usleep(DELAY);
+        long deadline = next_tick;
+        if (net_next_send() < deadline) deadline = net_next_send();
+        k = next_repeat();
+        if (k && k->next_repeat < deadline) deadline = k->next_repeat;
+        wait_until(deadline);
     }
+
+    Packet p;
+    p.type = PACKET_QUIT;
+    net_send(&p, now);
+    net_flush(LONG_MAX);
 }
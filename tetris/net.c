@@ -0,0 +1,169 @@
+#define _DEFAULT_SOURCE
+#include "net.h"
+
+#include <arpa/inet.h>
+#include <limits.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define PACKET_MAX (1 + 8 + 4 * 5 + 1 + VERSUS_WINDOW)
+#define HELD_MAX 256
+
+typedef struct {
+    long due;
+    int len;
+    unsigned char data[PACKET_MAX];
+} HeldPacket;
+
+static int sock = -1;
+static struct sockaddr_in peer;
+static long jitter = 0;
+static HeldPacket held[HELD_MAX];
+static int held_count = 0;
+
+int net_open(int player, int port) {
+    struct sockaddr_in self;
+    memset(&self, 0, sizeof(self));
+    self.sin_family = AF_INET;
+    self.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    self.sin_port = htons(port + (player == 1 ? 0 : 1));
+    peer = self;
+    peer.sin_port = htons(port + (player == 1 ? 1 : 0));
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0 || bind(sock, (struct sockaddr *)&self, sizeof(self)) != 0) {
+        perror("versus socket");
+        net_close();
+        return 0;
+    }
+    return 1;
+}
+
+void net_close(void) {
+    if (sock >= 0) close(sock);
+    sock = -1;
+    held_count = 0;
+}
+
+int net_fd(void) {
+    return sock;
+}
+
+void net_set_jitter(long max_us) {
+    jitter = max_us;
+}
+
+/* --- Wire format: little-endian, one type byte then the type's fields --- */
+
+static unsigned char *put32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) *p++ = (unsigned char)(v >> (8 * i));
+    return p;
+}
+
+static const unsigned char *get32(const unsigned char *p, int *v) {
+    uint32_t u = 0;
+    for (int i = 0; i < 4; i++) u |= (uint32_t)*p++ << (8 * i);
+    *v = (int)u;
+    return p;
+}
+
+static int encode(const Packet *pk, unsigned char *buf) {
+    unsigned char *p = buf;
+    *p++ = (unsigned char)pk->type;
+    if (pk->type == PACKET_HELLO) {
+        p = put32(p, (uint32_t)pk->seed);
+        p = put32(p, (uint32_t)(pk->seed >> 32));
+        p = put32(p, pk->width);
+        p = put32(p, pk->height);
+    } else if (pk->type == PACKET_INPUTS) {
+        p = put32(p, pk->ack);
+        p = put32(p, pk->frame);
+        p = put32(p, pk->advantage);
+        p = put32(p, pk->first);
+        *p++ = (unsigned char)pk->count;
+        memcpy(p, pk->masks, pk->count);
+        p += pk->count;
+    }
+    return (int)(p - buf);
+}
+
+static int decode(const unsigned char *buf, int len, Packet *pk) {
+    const unsigned char *p = buf;
+    if (len < 1) return 0;
+    pk->type = *p++;
+    if (pk->type == PACKET_HELLO) {
+        int lo, hi;
+        if (len != 17) return 0;
+        p = get32(p, &lo);
+        p = get32(p, &hi);
+        pk->seed = (uint32_t)lo | (uint64_t)(uint32_t)hi << 32;
+        p = get32(p, &pk->width);
+        get32(p, &pk->height);
+    } else if (pk->type == PACKET_INPUTS) {
+        if (len < 18) return 0;
+        p = get32(p, &pk->ack);
+        p = get32(p, &pk->frame);
+        p = get32(p, &pk->advantage);
+        p = get32(p, &pk->first);
+        pk->count = *p++;
+        if (pk->count > VERSUS_WINDOW || len != 18 + pk->count) return 0;
+        memcpy(pk->masks, p, pk->count);
+    } else if (pk->type != PACKET_QUIT) {
+        return 0;
+    }
+    return 1;
+}
+
+/* --- Sending --- */
+
+static void send_now(const unsigned char *data, int len) {
+    /* Loss is handled by resending, so errors are ignored */
+    ssize_t n = sendto(sock, data, len, 0, (struct sockaddr *)&peer, sizeof(peer));
+    (void)n;
+}
+
+void net_send(const Packet *p, long now) {
+    unsigned char buf[PACKET_MAX];
+    int len = encode(p, buf);
+    if (jitter <= 0 || held_count == HELD_MAX) {
+        send_now(buf, len);
+        return;
+    }
+    HeldPacket *h = &held[held_count++];
+    h->due = now + (long)(rand() % (jitter + 1));
+    h->len = len;
+    memcpy(h->data, buf, len);
+}
+
+void net_flush(long now) {
+    int kept = 0;
+    for (int i = 0; i < held_count; i++) {
+        if (held[i].due <= now) {
+            send_now(held[i].data, held[i].len);
+        } else {
+            held[kept++] = held[i];
+        }
+    }
+    held_count = kept;
+}
+
+long net_next_send(void) {
+    long due = LONG_MAX;
+    for (int i = 0; i < held_count; i++) {
+        if (held[i].due < due) due = held[i].due;
+    }
+    return due;
+}
+
+int net_recv(Packet *p) {
+    unsigned char buf[PACKET_MAX];
+    while (1) {
+        ssize_t n = recv(sock, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n < 0) return 0;
+        if (decode(buf, (int)n, p)) return 1;
+    }
+}
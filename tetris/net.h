@@ -0,0 +1,54 @@
+#ifndef NET_H
+#define NET_H
+
+/*
+ * Loopback UDP transport for versus mode.
+ *
+ * Player 1 binds 127.0.0.1:port and player 2 port + 1, each sending to
+ * the other. Packets are small and self-contained: every input packet
+ * carries all inputs the peer has not acknowledged, so a lost or
+ * reordered packet costs nothing but a little extra prediction.
+ *
+ * For testing, outgoing packets can be held back by a random delay,
+ * which both adds jitter and reorders them.
+ */
+
+#include <stdint.h>
+
+#include "versus.h"
+
+enum { PACKET_HELLO, PACKET_INPUTS, PACKET_QUIT };
+
+typedef struct {
+    int type;
+
+    /* PACKET_HELLO: match settings, chosen by player 1 */
+    uint64_t seed;
+    int width, height;
+
+    /* PACKET_INPUTS */
+    int ack;            /* sender has our inputs for frames below this */
+    int frame;          /* sender's present frame */
+    int advantage;      /* sender's frame minus ours, as last seen by the sender */
+    int first, count;   /* masks for frames first .. first + count - 1 */
+    uint8_t masks[VERSUS_WINDOW];
+} Packet;
+
+/* Returns 0 with a message on stderr if the socket cannot be set up. */
+int net_open(int player, int port);
+void net_close(void);
+int net_fd(void);
+
+/* Hold each outgoing packet back by a random 0..max_us. */
+void net_set_jitter(long max_us);
+
+void net_send(const Packet *p, long now);
+/* Send held-back packets that are due by `now`. */
+void net_flush(long now);
+/* When the next held-back packet is due; LONG_MAX if none. */
+long net_next_send(void);
+
+/* Read one packet without blocking. Returns 0 if none is waiting. */
+int net_recv(Packet *p);
+
+#endif
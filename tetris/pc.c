@@ -0,0 +1,431 @@
+#define _POSIX_C_SOURCE 200809L
+#include "pc.h"
+#include "bot.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ALL_TYPES 0x7F
+#define PC_AIR 8                /* empty rows kept above the region to spawn and turn in */
+#define TABLE_BITS 18           /* transposition table entries, as a power of two */
+#define CHECK_EVERY 64          /* positions between deadline and stop checks */
+
+/* Pieces still to come: the one to play, the HOLD slot, the NEXT piece
+   until it is drawn, then the types the current 7-bag has left. */
+typedef struct {
+    int cur;
+    int hold;           /* -1 if empty */
+    int can_hold;
+    int next;           /* -1 once drawn */
+    unsigned bag;
+} PcPieces;
+
+typedef struct {
+    Board board;        /* PC_AIR + lines rows, the region at the bottom */
+    uint64_t *table;    /* hashes of positions known to fail, 0 = empty */
+    long nodes;
+    long deadline;
+    const int *stop;
+    int aborted;
+
+    Tetromino start;    /* the current piece where it is now, in local rows */
+    int use_hold;       /* first move of the plan found */
+    Tetromino target;
+} Solver;
+
+static long clock_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+static uint64_t mix(uint64_t h, uint64_t v) {
+    h = (h ^ v) * 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 29);
+}
+
+/* Key of a region `f` rows tall and the pieces left to play in it */
+static uint64_t position_key(const Solver *s, const RowMask *rows, int f, const PcPieces *pc) {
+    uint64_t h = mix(f, (uint64_t)pc->cur | (uint64_t)(pc->hold + 1) << 3 |
+                        (uint64_t)pc->can_hold << 6 | (uint64_t)(pc->next + 1) << 7 |
+                        (uint64_t)pc->bag << 10);
+    for (int y = s->board.height - f; y < s->board.height; y++) h = mix(h, rows[y]);
+    return h | 1;
+}
+
+/* --- Pruning --- */
+
+/* Column parity: of the empty cells, those in even columns minus those in
+   odd ones. Line clears leave columns alone, so only the pieces change it:
+   an upright I by 4, every J and L and an upright T by 2, the rest by 0.
+   Indexed by type, I J L O S T Z. */
+static const int PARITY_SWING[7] = { 4, 2, 2, 0, 0, 2, 0 };
+
+static int by_swing_desc(const void *a, const void *b) {
+    return *(const int *)b - *(const int *)a;
+}
+
+/* Largest parity swing `k` placements can make: the known pieces plus the
+   best the bag could deal, one spare draw allowed for the HOLD slot. */
+static int max_swing(const PcPieces *pc, int k) {
+    int swing[PC_MAX_PIECES + 4], n = 0;
+    swing[n++] = PARITY_SWING[pc->cur];
+    if (pc->hold >= 0) swing[n++] = PARITY_SWING[pc->hold];
+    if (pc->next >= 0) swing[n++] = PARITY_SWING[pc->next];
+
+    unsigned bag = pc->bag;
+    for (int draws = 0; draws <= k && n < PC_MAX_PIECES + 4; draws++) {
+        if (!bag) bag = ALL_TYPES;
+        int best = -1;
+        for (int t = 0; t < 7; t++) {
+            if ((bag & (1u << t)) && (best < 0 || PARITY_SWING[t] > PARITY_SWING[best])) best = t;
+        }
+        bag &= ~(1u << best);
+        swing[n++] = PARITY_SWING[best];
+    }
+    qsort(swing, n, sizeof(int), by_swing_desc);
+
+    int total = 0;
+    for (int i = 0; i < k && i < n; i++) total += swing[i];
+    return total;
+}
+
+/* Pieces needed to fill the region exactly, or -1 if no whole number of
+   pieces can: the empty cells, and those between any two columns the
+   stack already fills to the top, must come in fours, and the column
+   parity must be within reach. */
+static int pieces_needed(const Solver *s, const RowMask *rows, int f, const PcPieces *pc) {
+    const Board *b = &s->board;
+    RowMask even = 0x5555555555555555ULL & b->full;
+    RowMask full_cols = b->full;
+    int empty = 0, parity = 0;
+    for (int y = b->height - f; y < b->height; y++) {
+        RowMask gaps = ~rows[y] & b->full;
+        empty += __builtin_popcountll(gaps);
+        parity += __builtin_popcountll(gaps & even) - __builtin_popcountll(gaps & ~even);
+        full_cols &= rows[y];
+    }
+    if (empty % 4) return -1;
+
+    /* Pieces cannot cross a filled column, so each side fills on its own */
+    RowMask rest = b->full & ~full_cols;
+    while (rest) {
+        RowMask low = rest & -rest;
+        RowMask segment = rest & ~(rest + low);  /* lowest run of open columns */
+        int cells = 0;
+        for (int y = b->height - f; y < b->height; y++) {
+            cells += __builtin_popcountll(segment & ~rows[y]);
+        }
+        if (cells % 4) return -1;
+        rest &= ~segment;
+    }
+
+    int k = empty / 4;
+    if (abs(parity) > max_swing(pc, k)) return -1;
+    return k;
+}
+
+/* --- Search --- */
+
+/* Lock `p` into a copy of the rows and clear full lines. Returns the
+   lines cleared, or -1 if any cell lies above the region. */
+static int place(const Solver *s, const RowMask *rows, int f, const Tetromino *p, RowMask *out) {
+    const Board *b = &s->board;
+    const PieceMask *m = &piece_masks[p->type][p->rotation];
+    if (p->y + m->min_y < b->height - f) return -1;
+
+    memcpy(out, rows, sizeof(RowMask) * b->height);
+    for (int i = m->min_y; i <= m->max_y; i++) {
+        out[p->y + i] |= p->x >= 0 ? m->rows[i] << p->x : m->rows[i] >> -p->x;
+    }
+    int dst = b->height - 1, lines = 0;
+    for (int y = b->height - 1; y >= b->height - f; y--) {
+        if (out[y] == b->full) {
+            lines++;
+            continue;
+        }
+        out[dst--] = out[y];
+    }
+    while (dst >= b->height - f) out[dst--] = 0;
+    return lines;
+}
+
+static int solve(Solver *s, const RowMask *rows, int f, const PcPieces *pc, int depth);
+
+/* Play `type` from `start` (NULL: its spawn position) everywhere it fits
+   in the region, then draw the next piece every way the queue or the bag
+   allows. `after` holds the pieces left once `type` is played. */
+static int play(Solver *s, const RowMask *rows, int f, int type, const Tetromino *start,
+                const PcPieces *after, int depth, int use_hold) {
+    const Board *b = &s->board;
+    Tetromino spawn, list[BOT_MAX_PLACEMENTS];
+    if (!start) {
+        spawn.type = type;
+        spawn.x = (b->width - SHAPES[type].grid_size) / 2;
+        spawn.y = 0;
+        spawn.rotation = 0;
+        spawn.color = SHAPES[type].color;
+        start = &spawn;
+    }
+    Board board = *b;
+    board.rows = (RowMask *)rows;
+    int n = bot_reachable(&board, start, list);
+
+    RowMask next[b->height];
+    for (int i = 0; i < n; i++) {
+        int lines = place(s, rows, f, &list[i], next);
+        if (lines < 0) continue;
+
+        PcPieces child = *after;
+        child.can_hold = 1;
+        int r = 0;
+        if (child.next >= 0) {
+            child.cur = child.next;
+            child.next = -1;
+            r = solve(s, next, f - lines, &child, depth + 1);
+        } else {
+            unsigned bag = after->bag ? after->bag : ALL_TYPES;
+            for (int t = 0; t < 7 && r == 0; t++) {
+                if (!(bag & (1u << t))) continue;
+                child.cur = t;
+                child.bag = bag & ~(1u << t);
+                r = solve(s, next, f - lines, &child, depth + 1);
+            }
+        }
+        if (r < 0) return -1;
+        if (r > 0) {
+            if (depth == 0) {
+                s->use_hold = use_hold;
+                s->target = list[i];
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* 1 if the region can be cleared with the pieces in `pc`, 0 if not, -1 if
+   the search was stopped. */
+static int solve(Solver *s, const RowMask *rows, int f, const PcPieces *pc, int depth) {
+    const Board *b = &s->board;
+    if (depth > 0) {
+        int empty = 1;
+        for (int y = b->height - f; y < b->height && empty; y++) empty = rows[y] == 0;
+        if (empty) return 1;
+    }
+    int k = pieces_needed(s, rows, f, pc);
+    if (k < 0 || depth + k > PC_MAX_PIECES) return 0;
+
+    uint64_t key = position_key(s, rows, f, pc);
+    uint64_t *slot = &s->table[key & ((1u << TABLE_BITS) - 1)];
+    if (*slot == key) return 0;
+
+    if (++s->nodes % CHECK_EVERY == 0 &&
+        (clock_us() > s->deadline || (s->stop && __atomic_load_n(s->stop, __ATOMIC_RELAXED)))) {
+        s->aborted = 1;
+    }
+    if (s->aborted) return -1;
+
+    /* Play the current piece... */
+    PcPieces after = *pc;
+    int r = play(s, rows, f, pc->cur, depth == 0 ? &s->start : NULL, &after, depth, 0);
+
+    /* ...or swap it into HOLD and play what comes out */
+    if (r == 0 && pc->can_hold) {
+        after.hold = pc->cur;
+        if (pc->hold >= 0) {
+            r = play(s, rows, f, pc->hold, NULL, &after, depth, 1);
+        } else if (pc->next >= 0) {
+            after.next = -1;
+            r = play(s, rows, f, pc->next, NULL, &after, depth, 1);
+        } else {
+            unsigned bag = pc->bag ? pc->bag : ALL_TYPES;
+            for (int t = 0; t < 7 && r == 0; t++) {
+                if (!(bag & (1u << t))) continue;
+                after.bag = bag & ~(1u << t);
+                r = play(s, rows, f, t, NULL, &after, depth, 1);
+            }
+        }
+    }
+
+    if (r == 0) *slot = key;
+    return r;
+}
+
+/* Types the current bag still holds after the NEXT piece. */
+static unsigned bag_remaining(const TetrisGame *g) {
+    unsigned bag = 0;
+    for (int i = g->bag_ptr; i < 7; i++) bag |= 1u << g->bag[i];
+    return bag;
+}
+
+void pc_solve(const TetrisGame *g, int max_lines, long deadline, const int *stop, PcResult *out) {
+    long start_time = clock_us();
+    const Board *gb = &g->board;
+    memset(out, 0, sizeof(*out));
+    out->status = PC_NONE;
+    if (max_lines > PC_MAX_LINES) max_lines = PC_MAX_LINES;
+    if (max_lines > gb->height) max_lines = gb->height;
+
+    int top = 0;
+    for (int x = 0; x < gb->width; x++) {
+        if (g->heights[x] > top) top = g->heights[x];
+    }
+    if (g->game_over || top > max_lines) return;
+
+    /* The bottom rows of the game, under PC_AIR rows of free air */
+    Solver s;
+    memset(&s, 0, sizeof(s));
+    int height = PC_AIR + max_lines;
+    RowMask rows[PC_AIR + PC_MAX_LINES];
+    memset(rows, 0, sizeof(rows));
+    memcpy(rows + PC_AIR, gb->rows + gb->height - max_lines, sizeof(RowMask) * max_lines);
+    s.board.width = gb->width;
+    s.board.height = height;
+    s.board.full = gb->full;
+    s.board.rows = rows;
+    s.deadline = deadline;
+    s.stop = stop;
+    s.table = calloc((size_t)1 << TABLE_BITS, sizeof(uint64_t));
+
+    int off = gb->height - height;
+    s.start = g->current;
+    s.start.y -= off;
+    if (s.start.y < 0) s.start.y = 0;   /* anywhere in free air is alike */
+
+    PcPieces pc = { g->current.type, g->hold_type, g->can_hold, g->next_type, bag_remaining(g) };
+
+    /* Lowest region first: fewer pieces, and what a player would want */
+    for (int f = top > 0 ? top : 1; f <= max_lines && out->status == PC_NONE; f++) {
+        int r = solve(&s, rows, f, &pc, 0);
+        if (r < 0) {
+            out->status = PC_ABORTED;
+        } else if (r > 0) {
+            out->status = PC_FOUND;
+            out->lines = f;
+            out->pieces = pieces_needed(&s, rows, f, &pc);
+            out->use_hold = s.use_hold;
+            out->target = s.target;
+            out->target.y += off;
+        }
+    }
+    out->nodes = s.nodes;
+    out->elapsed_us = clock_us() - start_time;
+    free(s.table);
+}
+
+/* --- Background hints --- */
+
+struct PcHint {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    int pipe[2];            /* one byte waiting while a result is */
+
+    TetrisGame request;     /* snapshot of the latest request */
+    int max_lines;
+    long budget_us;
+    int requested;          /* serial of the latest request */
+    int taken;              /* serial the worker last picked up */
+    int stop;               /* set to cancel the running search */
+    int quit;
+
+    PcResult result;
+    int ready;
+};
+
+static void *hint_worker(void *arg) {
+    PcHint *h = arg;
+    TetrisGame g;
+    memset(&g, 0, sizeof(g));
+
+    pthread_mutex_lock(&h->lock);
+    while (1) {
+        while (!h->quit && h->taken == h->requested) pthread_cond_wait(&h->wake, &h->lock);
+        if (h->quit) break;
+        int serial = h->taken = h->requested;
+        copy_game(&g, &h->request);
+        int max_lines = h->max_lines;
+        long deadline = clock_us() + h->budget_us;
+        __atomic_store_n(&h->stop, 0, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&h->lock);
+
+        PcResult r;
+        pc_solve(&g, max_lines, deadline, &h->stop, &r);
+
+        pthread_mutex_lock(&h->lock);
+        if (serial == h->requested) {
+            h->result = r;
+            if (!h->ready) {
+                char c = 1;
+                ssize_t n = write(h->pipe[1], &c, 1);
+                (void)n;
+            }
+            h->ready = 1;
+        }
+    }
+    pthread_mutex_unlock(&h->lock);
+    free_game(&g);
+    return NULL;
+}
+
+PcHint *pc_hint_create(void) {
+    PcHint *h = calloc(1, sizeof(PcHint));
+    if (pipe(h->pipe) != 0) {
+        free(h);
+        return NULL;
+    }
+    fcntl(h->pipe[0], F_SETFL, O_NONBLOCK);
+    pthread_mutex_init(&h->lock, NULL);
+    pthread_cond_init(&h->wake, NULL);
+    pthread_create(&h->thread, NULL, hint_worker, h);
+    return h;
+}
+
+void pc_hint_destroy(PcHint *h) {
+    if (!h) return;
+    pthread_mutex_lock(&h->lock);
+    h->quit = 1;
+    __atomic_store_n(&h->stop, 1, __ATOMIC_RELAXED);
+    pthread_cond_signal(&h->wake);
+    pthread_mutex_unlock(&h->lock);
+    pthread_join(h->thread, NULL);
+
+    pthread_mutex_destroy(&h->lock);
+    pthread_cond_destroy(&h->wake);
+    close(h->pipe[0]);
+    close(h->pipe[1]);
+    free_game(&h->request);
+    free(h);
+}
+
+void pc_hint_start(PcHint *h, const TetrisGame *g, int max_lines, long budget_us) {
+    pthread_mutex_lock(&h->lock);
+    copy_game(&h->request, g);
+    h->max_lines = max_lines;
+    h->budget_us = budget_us;
+    h->requested++;
+    h->ready = 0;
+    __atomic_store_n(&h->stop, 1, __ATOMIC_RELAXED);
+    pthread_cond_signal(&h->wake);
+    pthread_mutex_unlock(&h->lock);
+}
+
+int pc_hint_poll(PcHint *h, PcResult *out) {
+    char buf[16];
+    pthread_mutex_lock(&h->lock);
+    int ready = h->ready;
+    if (ready) *out = h->result;
+    h->ready = 0;
+    while (read(h->pipe[0], buf, sizeof(buf)) > 0) {}
+    pthread_mutex_unlock(&h->lock);
+    return ready;
+}
+
+int pc_hint_fd(const PcHint *h) {
+    return h->pipe[0];
+}
@@ -0,0 +1,62 @@
+#ifndef PC_H
+#define PC_H
+
+/*
+ * Perfect-clear finder.
+ *
+ * Searches for a sequence of placements that empties the board within the
+ * bottom N lines, playing the current piece, the HOLD slot and the NEXT
+ * piece as the game would and, past those, whatever the 7-bag can still
+ * deal. Beyond the visible pieces the search assumes a favourable bag
+ * order, so only the first placement of a plan is certain to be
+ * playable; it is re-run as each piece arrives.
+ *
+ * Positions that failed are kept in a transposition table keyed on the
+ * board rows and the piece state. Boards whose empty cells cannot be
+ * covered by whole pieces, or whose column parity the remaining pieces
+ * cannot balance, are pruned without placing anything.
+ *
+ * A PcHint runs the search on a background thread so a front end can
+ * show the result when it arrives without ever waiting for it.
+ */
+
+#include "tetris.h"
+
+#define PC_MAX_LINES 6
+#define PC_MAX_PIECES 16        /* longest plan searched */
+#define PC_BUDGET_US 1000000    /* default search time per piece */
+
+enum { PC_NONE, PC_FOUND, PC_ABORTED };
+
+typedef struct {
+    int status;         /* PC_NONE: proven impossible within the lines */
+    int pieces;         /* placements in the plan */
+    int lines;          /* height of the cleared region */
+    int use_hold;       /* first move: press hold, then place the held-out piece */
+    Tetromino target;   /* first placement, in board coordinates */
+    long nodes;         /* positions searched */
+    long elapsed_us;
+} PcResult;
+
+/* Search `g` for a perfect clear within max_lines (<= PC_MAX_LINES) of
+   the floor. Gives up with PC_ABORTED at `deadline` (CLOCK_MONOTONIC
+   microseconds) or as soon as *stop becomes nonzero; stop may be NULL. */
+void pc_solve(const TetrisGame *g, int max_lines, long deadline, const int *stop, PcResult *out);
+
+typedef struct PcHint PcHint;
+
+PcHint *pc_hint_create(void);
+void pc_hint_destroy(PcHint *h);
+
+/* Start searching a snapshot of `g`, cancelling any search still running
+   for an earlier request. Returns immediately. */
+void pc_hint_start(PcHint *h, const TetrisGame *g, int max_lines, long budget_us);
+
+/* Fetch the result of the latest request once. Returns 0 while it is
+   still running or after it was fetched. */
+int pc_hint_poll(PcHint *h, PcResult *out);
+
+/* Becomes readable when a result is waiting, for select(). */
+int pc_hint_fd(const PcHint *h);
+
+#endif
@@ -0,0 +1,202 @@
+#define _POSIX_C_SOURCE 200809L
+#include "pool.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct {
+    TaskFn fn;
+    void *arg;
+} Task;
+
+typedef struct {
+    pthread_mutex_t lock;
+    Task *tasks;
+    int head, tail, cap;    /* live tasks are tasks[head..tail) */
+} WorkDeque;
+
+typedef struct {
+    ThreadPool *pool;
+    int index;
+} Worker;
+
+struct ThreadPool {
+    int nthreads;
+    pthread_t *threads;
+    Worker *workers;
+    WorkDeque *deques;
+
+    pthread_mutex_t lock;   /* guards everything below */
+    pthread_cond_t work_ready;
+    pthread_cond_t all_done;
+    int queued;             /* tasks sitting in a deque */
+    int pending;            /* tasks submitted but not yet finished */
+    int shutdown;
+    int next_deque;
+    long steals;
+};
+
+static void deque_push_back(WorkDeque *d, Task t) {
+    pthread_mutex_lock(&d->lock);
+    if (d->tail == d->cap) {
+        if (d->head > 0) {
+            /* Slide live tasks down before growing */
+            for (int i = d->head; i < d->tail; i++) d->tasks[i - d->head] = d->tasks[i];
+            d->tail -= d->head;
+            d->head = 0;
+        }
+        if (d->tail == d->cap) {
+            d->cap = d->cap ? d->cap * 2 : 64;
+            d->tasks = realloc(d->tasks, sizeof(Task) * d->cap);
+        }
+    }
+    d->tasks[d->tail++] = t;
+    pthread_mutex_unlock(&d->lock);
+}
+
+static int deque_pop_back(WorkDeque *d, Task *out) {
+    int ok = 0;
+    pthread_mutex_lock(&d->lock);
+    if (d->tail > d->head) {
+        *out = d->tasks[--d->tail];
+        ok = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+static int deque_steal_front(WorkDeque *d, Task *out) {
+    int ok = 0;
+    pthread_mutex_lock(&d->lock);
+    if (d->tail > d->head) {
+        *out = d->tasks[d->head++];
+        ok = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return ok;
+}
+
+/* Own deque first, then sweep the others starting with the next worker. */
+static int take_task(ThreadPool *pool, int self, Task *out) {
+    int stolen = 0;
+    int found = deque_pop_back(&pool->deques[self], out);
+    for (int i = 1; !found && i < pool->nthreads; i++) {
+        found = deque_steal_front(&pool->deques[(self + i) % pool->nthreads], out);
+        stolen = found;
+    }
+    if (found) {
+        pthread_mutex_lock(&pool->lock);
+        pool->queued--;
+        pool->steals += stolen;
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return found;
+}
+
+static void *worker_main(void *arg) {
+    Worker *w = arg;
+    ThreadPool *pool = w->pool;
+
+    while (1) {
+        Task t;
+        if (!take_task(pool, w->index, &t)) {
+            pthread_mutex_lock(&pool->lock);
+            while (pool->queued <= 0 && !pool->shutdown) {
+                pthread_cond_wait(&pool->work_ready, &pool->lock);
+            }
+            int done = pool->shutdown && pool->queued <= 0;
+            pthread_mutex_unlock(&pool->lock);
+            if (done) return NULL;
+            continue;
+        }
+
+        t.fn(t.arg);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) pthread_cond_broadcast(&pool->all_done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+ThreadPool *pool_create(int threads) {
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) threads = 1;
+
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    pool->nthreads = threads;
+    pool->threads = calloc(threads, sizeof(pthread_t));
+    pool->workers = calloc(threads, sizeof(Worker));
+    pool->deques = calloc(threads, sizeof(WorkDeque));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->all_done, NULL);
+
+    for (int i = 0; i < threads; i++) {
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+    }
+    for (int i = 0; i < threads; i++) {
+        pthread_create(&pool->threads[i], NULL, worker_main, &pool->workers[i]);
+    }
+    return pool;
+}
+
+void pool_destroy(ThreadPool *pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->nthreads; i++) pthread_join(pool->threads[i], NULL);
+    for (int i = 0; i < pool->nthreads; i++) {
+        pthread_mutex_destroy(&pool->deques[i].lock);
+        free(pool->deques[i].tasks);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_cond_destroy(&pool->all_done);
+    free(pool->deques);
+    free(pool->workers);
+    free(pool->threads);
+    free(pool);
+}
+
+int pool_size(const ThreadPool *pool) {
+    return pool->nthreads;
+}
+
+void pool_submit(ThreadPool *pool, TaskFn fn, void *arg) {
+    Task t = { fn, arg };
+
+    /* Count the task before it becomes visible so pending never dips to 0
+       while it is still in flight */
+    pthread_mutex_lock(&pool->lock);
+    int idx = pool->next_deque;
+    pool->next_deque = (pool->next_deque + 1) % pool->nthreads;
+    pool->queued++;
+    pool->pending++;
+    pthread_mutex_unlock(&pool->lock);
+
+    deque_push_back(&pool->deques[idx], t);
+
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void pool_wait(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) pthread_cond_wait(&pool->all_done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+long pool_steals(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    long steals = pool->steals;
+    pthread_mutex_unlock(&pool->lock);
+    return steals;
+}
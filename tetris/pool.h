@@ -0,0 +1,29 @@
+#ifndef POOL_H
+#define POOL_H
+
+/*
+ * Small work-stealing thread pool.
+ *
+ * Each worker owns a deque: it pops its own work from the back and, when
+ * that runs dry, steals from the front of the other workers' deques.
+ * Submitted tasks are dealt round-robin across the deques, so uneven task
+ * costs get rebalanced by stealing rather than by a central queue lock.
+ */
+
+typedef void (*TaskFn)(void *arg);
+
+typedef struct ThreadPool ThreadPool;
+
+/* threads <= 0 means one worker per online CPU. */
+ThreadPool *pool_create(int threads);
+void pool_destroy(ThreadPool *pool);
+int pool_size(const ThreadPool *pool);
+
+void pool_submit(ThreadPool *pool, TaskFn fn, void *arg);
+/* Block until every submitted task has finished. */
+void pool_wait(ThreadPool *pool);
+
+/* Total number of tasks a worker took from another worker's deque. */
+long pool_steals(ThreadPool *pool);
+
+#endif
@@ -0,0 +1,151 @@
+#define _DEFAULT_SOURCE
+#include "render.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+typedef struct {
+    char ch;
+    unsigned char pair;
+    attr_t attr;
+} Cell;
+
+ScreenStats screen_stats;
+
+static Cell *back = NULL;       /* frame being composed */
+static Cell *front = NULL;      /* what the terminal shows */
+static int scr_h = 0, scr_w = 0;
+
+/* Byte rate sampling */
+static long sample_time = 0;
+static long long sample_bytes = -1;
+static long sample_frames = 0, sample_skipped = 0, sample_cells = 0;
+
+static long now_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (tv.tv_sec * 1000000) + tv.tv_usec;
+}
+
+/* Bytes this process has passed to write(), which during play is all
+   terminal output. Linux only; -1 elsewhere. */
+static long long bytes_written(void) {
+    FILE *f = fopen("/proc/self/io", "r");
+    if (!f) return -1;
+    char line[64];
+    long long n = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "wchar: %lld", &n) == 1) break;
+    }
+    fclose(f);
+    return n;
+}
+
+void screen_invalidate(void) {
+    /* A cell no frame can contain, so everything compares as changed */
+    for (int i = 0; i < scr_h * scr_w; i++) front[i].ch = 0;
+}
+
+void screen_begin(int term_h, int term_w) {
+    if (term_h != scr_h || term_w != scr_w) {
+        free(back);
+        free(front);
+        scr_h = term_h;
+        scr_w = term_w;
+        back = malloc(sizeof(Cell) * scr_h * scr_w);
+        front = malloc(sizeof(Cell) * scr_h * scr_w);
+        screen_invalidate();
+        clear();
+    }
+    for (int i = 0; i < scr_h * scr_w; i++) {
+        back[i].ch = ' ';
+        back[i].pair = 0;
+        back[i].attr = A_NORMAL;
+    }
+}
+
+void screen_put(int y, int x, const char *s, int pair, attr_t attr) {
+    if (y < 0 || y >= scr_h) return;
+    for (; *s; s++, x++) {
+        if (x < 0) continue;
+        if (x >= scr_w) break;
+        Cell *c = &back[y * scr_w + x];
+        c->ch = *s;
+        c->pair = (unsigned char)pair;
+        c->attr = attr;
+    }
+}
+
+void screen_printf(int y, int x, int pair, attr_t attr, const char *fmt, ...) {
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    screen_put(y, x, buf, pair, attr);
+}
+
+long screen_flush(void) {
+    long cells = 0;
+    char run[512];
+
+    for (int y = 0; y < scr_h; y++) {
+        int x = 0;
+        while (x < scr_w) {
+            Cell *b = &back[y * scr_w + x];
+            Cell *f = &front[y * scr_w + x];
+            if (b->ch == f->ch && b->pair == f->pair && b->attr == f->attr) {
+                x++;
+                continue;
+            }
+
+            /* Batch a run of changed cells with the same attributes */
+            int start = x, n = 0;
+            while (x < scr_w && n < (int)sizeof(run) - 1) {
+                b = &back[y * scr_w + x];
+                f = &front[y * scr_w + x];
+                if (b->pair != back[y * scr_w + start].pair ||
+                    b->attr != back[y * scr_w + start].attr) break;
+                if (b->ch == f->ch && b->pair == f->pair && b->attr == f->attr) break;
+                run[n++] = b->ch;
+                *f = *b;
+                x++;
+            }
+            run[n] = '\0';
+            attrset(COLOR_PAIR(back[y * scr_w + start].pair) | back[y * scr_w + start].attr);
+            mvaddnstr(y, start, run, n);
+            cells += n;
+        }
+    }
+    attrset(A_NORMAL);
+
+    screen_stats.frames++;
+    screen_stats.cells_last = cells;
+    screen_stats.cells_total += cells;
+    if (cells) {
+        refresh();
+    } else {
+        screen_stats.frames_skipped++;
+    }
+
+    long now = now_us();
+    if (now - sample_time >= 1000000) {
+        ScreenStats *s = &screen_stats;
+        long frames = s->frames - sample_frames;
+        long long bytes = bytes_written();
+        if (sample_bytes >= 0 && bytes >= 0) {
+            s->bytes_per_sec = (bytes - sample_bytes) / ((now - sample_time) / 1e6);
+        }
+        s->cells_per_frame = (double)(s->cells_total - sample_cells) / frames;
+        s->idle_percent = 100.0 * (s->frames_skipped - sample_skipped) / frames;
+        sample_bytes = bytes;
+        sample_time = now;
+        sample_frames = s->frames;
+        sample_skipped = s->frames_skipped;
+        sample_cells = s->cells_total;
+    }
+    return cells;
+}
@@ -0,0 +1,42 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+/*
+ * Damage-tracked screen output.
+ *
+ * Each frame is composed into a back buffer with screen_put(), then
+ * screen_flush() compares it with a shadow copy of what was last sent and
+ * only hands the changed cells to ncurses. A frame with no changes skips
+ * refresh() entirely.
+ */
+
+#include <ncurses.h>
+
+typedef struct {
+    long frames;            /* frames flushed */
+    long frames_skipped;    /* frames with no changed cells */
+    long cells_last;        /* cells written by the most recent flush */
+    long cells_total;
+
+    /* Sampled once a second, so an overlay showing them stays still */
+    double cells_per_frame;
+    double idle_percent;    /* share of frames that skipped refresh() */
+    double bytes_per_sec;   /* terminal output */
+} ScreenStats;
+
+extern ScreenStats screen_stats;
+
+/* Start a new frame sized to the terminal. A size change clears the
+   terminal and forces a full repaint. */
+void screen_begin(int term_h, int term_w);
+
+/* Forget what is on the terminal, e.g. after another window covered it. */
+void screen_invalidate(void);
+
+void screen_put(int y, int x, const char *s, int pair, attr_t attr);
+void screen_printf(int y, int x, int pair, attr_t attr, const char *fmt, ...);
+
+/* Emit the changed cells. Returns the number of cells written. */
+long screen_flush(void);
+
+#endif
@@ -0,0 +1,201 @@
+#include "replay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char MAGIC[4] = { 'T', 'R', 'P', 'L' };
+
+/* --- Varints --- */
+
+static void put_byte(Replay *r, unsigned char b) {
+    if (r->len == r->cap) {
+        r->cap = r->cap ? r->cap * 2 : 256;
+        r->events = realloc(r->events, r->cap);
+    }
+    r->events[r->len++] = b;
+}
+
+static void put_varint(Replay *r, uint64_t v) {
+    while (v >= 0x80) {
+        put_byte(r, (unsigned char)(v | 0x80));
+        v >>= 7;
+    }
+    put_byte(r, (unsigned char)v);
+}
+
+static int write_varint(FILE *f, uint64_t v) {
+    while (v >= 0x80) {
+        if (fputc((int)((v & 0x7F) | 0x80), f) == EOF) return 0;
+        v >>= 7;
+    }
+    return fputc((int)v, f) != EOF;
+}
+
+static int read_varint(FILE *f, uint64_t *out) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = fgetc(f);
+        if (c == EOF) return 0;
+        v |= (uint64_t)(c & 0x7F) << shift;
+        if (!(c & 0x80)) {
+            *out = v;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int get_varint(const Replay *r, size_t *pos, uint64_t *out) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64 && *pos < r->len; shift += 7) {
+        unsigned char c = r->events[(*pos)++];
+        v |= (uint64_t)(c & 0x7F) << shift;
+        if (!(c & 0x80)) {
+            *out = v;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* --- Recording --- */
+
+void replay_start(Replay *r, const TetrisGame *g, long now) {
+    r->seed = g->seed;
+    r->drop_rate = g->drop_rate;
+    r->width = g->board.width;
+    r->height = g->board.height;
+    r->len = 0;
+    r->score = r->lines = r->pieces = 0;
+    r->hash = 0;
+    r->start_time = now;
+    r->last_time = now;
+}
+
+static void put_event(Replay *r, int code, long now) {
+    long delta = now - r->last_time;
+    if (delta < 0) delta = 0;
+    put_varint(r, ((uint64_t)delta << 3) | (unsigned)code);
+    r->last_time += delta;
+}
+
+void replay_record(Replay *r, int input, long now) {
+    put_event(r, input, now);
+}
+
+void replay_finish(Replay *r, const TetrisGame *g, long now) {
+    put_event(r, REPLAY_END, now);
+    r->score = g->score;
+    r->lines = g->lines;
+    r->pieces = g->pieces;
+    r->hash = board_hash(g);
+}
+
+int replay_save(const Replay *r, const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return 0;
+
+    int ok = fwrite(MAGIC, 1, sizeof(MAGIC), f) == sizeof(MAGIC) &&
+             write_varint(f, REPLAY_VERSION) &&
+             write_varint(f, r->seed) &&
+             write_varint(f, (uint64_t)r->drop_rate) &&
+             write_varint(f, (uint64_t)r->width) &&
+             write_varint(f, (uint64_t)r->height) &&
+             fwrite(r->events, 1, r->len, f) == r->len &&
+             write_varint(f, (uint64_t)r->score) &&
+             write_varint(f, (uint64_t)r->lines) &&
+             write_varint(f, (uint64_t)r->pieces) &&
+             write_varint(f, r->hash);
+    if (fclose(f) != 0) ok = 0;
+    return ok;
+}
+
+int replay_load(Replay *r, const char *path) {
+    memset(r, 0, sizeof(*r));
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+
+    char magic[4];
+    uint64_t version, drop_rate, width = BOARD_WIDTH, height = BOARD_HEIGHT, v;
+    int ok = fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+             memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 &&
+             read_varint(f, &version) && version >= 1 && version <= REPLAY_VERSION &&
+             read_varint(f, &r->seed) &&
+             read_varint(f, &drop_rate);
+    if (ok && version >= 2) {
+        ok = read_varint(f, &width) && read_varint(f, &height) &&
+             width >= 4 && width <= BOARD_MAX_WIDTH && height >= 4 && height <= BOARD_MAX_HEIGHT;
+    }
+    r->drop_rate = (long)drop_rate;
+    r->width = (int)width;
+    r->height = (int)height;
+
+    /* Copy events through the end marker */
+    while (ok) {
+        if (!read_varint(f, &v)) {
+            ok = 0;
+            break;
+        }
+        put_varint(r, v);
+        if ((v & 7) == REPLAY_END) break;
+    }
+
+    uint64_t score, lines, pieces;
+    ok = ok && read_varint(f, &score) && read_varint(f, &lines) &&
+         read_varint(f, &pieces) && read_varint(f, &r->hash);
+    r->score = (int)score;
+    r->lines = (int)lines;
+    r->pieces = (int)pieces;
+
+    fclose(f);
+    if (!ok) replay_free(r);
+    return ok;
+}
+
+void replay_free(Replay *r) {
+    free(r->events);
+    r->events = NULL;
+    r->len = r->cap = 0;
+}
+
+/* --- Playback --- */
+
+int replay_next(const Replay *r, ReplayCursor *c, int *input, long *offset) {
+    uint64_t v;
+    if (!get_varint(r, &c->pos, &v)) {
+        *offset = c->time;
+        return 0;
+    }
+    c->time += (long)(v >> 3);
+    *input = (int)(v & 7);
+    *offset = c->time;
+    if (*input == REPLAY_END) return 0;
+    c->events++;
+    return 1;
+}
+
+void replay_init_game(const Replay *r, TetrisGame *g) {
+    init_game_size(g, r->width, r->height, r->seed, 0);
+    g->drop_rate = r->drop_rate;
+}
+
+int replay_verify(const Replay *r, TetrisGame *g, Finesse *f, ReplayCursor *end) {
+    ReplayCursor c = { 0, 0, 0 };
+    int input;
+    long t;
+
+    replay_init_game(r, g);
+    if (f) finesse_init(f, g);
+    while (replay_next(r, &c, &input, &t)) {
+        update_game(g, t);
+        apply_input(g, input, t);
+        if (f) finesse_input(f, g, input);
+    }
+    update_game(g, t);
+    if (f) finesse_sync(f, g);
+    if (end) *end = c;
+
+    return g->score == r->score && g->lines == r->lines &&
+           g->pieces == r->pieces && board_hash(g) == r->hash;
+}
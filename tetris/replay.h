@@ -0,0 +1,82 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+/*
+ * Compact binary replays.
+ *
+ * A replay is the seed plus every INPUT_* event with its time offset from
+ * the start of the game. Since the core is deterministic, that is enough
+ * to rebuild the whole run; the final score, line count and board hash
+ * are stored alongside so a re-simulation can be checked against them.
+ *
+ * File layout, all integers unsigned LEB128 varints:
+ *
+ *   "TRPL" version seed drop_rate width height
+ *   event* where event = (delta_us << 3) | code, code 0..6 = INPUT_*
+ *   end    = (delta_us << 3) | REPLAY_END
+ *   score lines pieces hash
+ *
+ * Deltas are from the previous event, so a typical key press costs 2 bytes.
+ * Version 1 files have no width and height and are played on the default
+ * board.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "finesse.h"
+#include "tetris.h"
+
+#define REPLAY_VERSION 2
+#define REPLAY_END 7
+
+typedef struct {
+    uint64_t seed;
+    long drop_rate;             /* initial drop rate (--gravity changes it) */
+    int width, height;          /* board size */
+
+    unsigned char *events;      /* encoded event stream, ends with REPLAY_END */
+    size_t len, cap;
+
+    /* Result of the recorded run */
+    int score;
+    int lines;
+    int pieces;
+    uint64_t hash;
+
+    /* Recording state */
+    long start_time;
+    long last_time;
+} Replay;
+
+/* Recording */
+void replay_start(Replay *r, const TetrisGame *g, long now);
+void replay_record(Replay *r, int input, long now);
+void replay_finish(Replay *r, const TetrisGame *g, long now);
+
+int replay_save(const Replay *r, const char *path);
+int replay_load(Replay *r, const char *path);
+void replay_free(Replay *r);
+
+/* Playback: iterate events in order. Returns 0 at the end marker, where
+   *offset is the end time. */
+typedef struct {
+    size_t pos;
+    long time;
+    long events;                /* events read so far */
+} ReplayCursor;
+
+int replay_next(const Replay *r, ReplayCursor *c, int *input, long *offset);
+
+/* Start a game in the state the recording started from, at virtual time 0.
+   Release it with free_game(). */
+void replay_init_game(const Replay *r, TetrisGame *g);
+
+/* Re-simulate the whole run as fast as possible into `g`, which must then
+   be released with free_game(). Returns 1 if the final score, lines, piece
+   count and board hash all match the recording. If `f` is not NULL it
+   judges finesse along the way; if `end` is not NULL it receives the
+   cursor at the end marker, with the event count and end time. */
+int replay_verify(const Replay *r, TetrisGame *g, Finesse *f, ReplayCursor *end);
+
+#endif
@@ -0,0 +1,561 @@
+#include "tetris.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Shapes Definition */
+const TetrominoDef SHAPES[7] = {
+    /* I - Type 0 */
+    { { {0,0,0,0}, {1,1,1,1}, {0,0,0,0}, {0,0,0,0} }, 1, 4 },
+    /* J - Type 1 */
+    { { {1,0,0,0}, {1,1,1,0}, {0,0,0,0}, {0,0,0,0} }, 2, 3 },
+    /* L - Type 2 */
+    { { {0,0,1,0}, {1,1,1,0}, {0,0,0,0}, {0,0,0,0} }, 3, 3 },
+    /* O - Type 3 */
+    { { {1,1,0,0}, {1,1,0,0}, {0,0,0,0}, {0,0,0,0} }, 4, 2 },
+    /* S - Type 4 */
+    { { {0,1,1,0}, {1,1,0,0}, {0,0,0,0}, {0,0,0,0} }, 5, 3 },
+    /* T - Type 5 */
+    { { {0,1,0,0}, {1,1,1,0}, {0,0,0,0}, {0,0,0,0} }, 6, 3 },
+    /* Z - Type 6 */
+    { { {1,1,0,0}, {0,1,1,0}, {0,0,0,0}, {0,0,0,0} }, 7, 3 }
+};
+
+PieceMask piece_masks[7][4];
+
+/* SRS Wall Kick Data (J, L, S, T, Z) - Adapted for Y-Down (Screen) Coords */
+static const int KICKS_JLSTZ[8][5][2] = {
+    {{0,0}, {-1,0}, {-1,-1}, { 0, 2}, {-1, 2}}, /* 0->1 */
+    {{0,0}, { 1,0}, { 1, 1}, { 0,-2}, { 1,-2}}, /* 1->0 */
+    {{0,0}, { 1,0}, { 1, 1}, { 0,-2}, { 1,-2}}, /* 1->2 */
+    {{0,0}, {-1,0}, {-1,-1}, { 0, 2}, {-1, 2}}, /* 2->1 */
+    {{0,0}, { 1,0}, { 1,-1}, { 0, 2}, { 1, 2}}, /* 2->3 */
+    {{0,0}, {-1,0}, {-1, 1}, { 0,-2}, {-1,-2}}, /* 3->2 */
+    {{0,0}, {-1,0}, {-1, 1}, { 0,-2}, {-1,-2}}, /* 3->0 */
+    {{0,0}, { 1,0}, { 1,-1}, { 0, 2}, { 1, 2}}  /* 0->3 */
+};
+
+static const int KICKS_I[8][5][2] = {
+    {{0,0}, {-2,0}, { 1,0}, {-2, 1}, { 1,-2}}, /* 0->1 */
+    {{0,0}, { 2,0}, {-1,0}, { 2,-1}, {-1, 2}}, /* 1->0 */
+    {{0,0}, {-1,0}, { 2,0}, {-1,-2}, { 2, 1}}, /* 1->2 */
+    {{0,0}, { 1,0}, {-2,0}, { 1, 2}, {-2,-1}}, /* 2->1 */
+    {{0,0}, { 2,0}, {-1,0}, { 2,-1}, {-1, 2}}, /* 2->3 */
+    {{0,0}, {-2,0}, { 1,0}, {-2, 1}, { 1,-2}}, /* 3->2 */
+    {{0,0}, { 1,0}, {-2,0}, { 1, 2}, {-2,-1}}, /* 3->0 */
+    {{0,0}, {-1,0}, { 2,0}, {-1,-2}, { 2, 1}}  /* 0->3 */
+};
+
+static int get_kick_index(int old_rot, int new_rot) {
+    if (old_rot == 0 && new_rot == 1) return 0;
+    if (old_rot == 1 && new_rot == 0) return 1;
+    if (old_rot == 1 && new_rot == 2) return 2;
+    if (old_rot == 2 && new_rot == 1) return 3;
+    if (old_rot == 2 && new_rot == 3) return 4;
+    if (old_rot == 3 && new_rot == 2) return 5;
+    if (old_rot == 3 && new_rot == 0) return 6;
+    if (old_rot == 0 && new_rot == 3) return 7;
+    return 0;
+}
+
+static int get_block(int type, int rot, int x, int y) {
+    int size = SHAPES[type].grid_size;
+    if (size == 2) return SHAPES[type].shape[y][x];
+
+    int r = rot % 4;
+    int tx = x, ty = y;
+
+    for (int i = 0; i < r; i++) {
+        int temp = tx;
+        tx = size - 1 - ty;
+        ty = temp;
+    }
+
+    if (tx < 0 || tx >= 4 || ty < 0 || ty >= 4) return 0;
+
+    return SHAPES[type].shape[ty][tx];
+}
+
+void init_piece_masks(void) {
+    for (int type = 0; type < 7; type++) {
+        for (int rot = 0; rot < 4; rot++) {
+            PieceMask *m = &piece_masks[type][rot];
+            memset(m, 0, sizeof(*m));
+            m->min_x = m->min_y = 4;
+            m->max_x = m->max_y = -1;
+            for (int j = 0; j < 4; j++) m->top[j] = m->bottom[j] = -1;
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 4; j++) {
+                    if (!get_block(type, rot, j, i)) continue;
+                    m->rows[i] |= (RowMask)1 << j;
+                    if (m->top[j] < 0) m->top[j] = i;
+                    m->bottom[j] = i;
+                    if (j < m->min_x) m->min_x = j;
+                    if (j > m->max_x) m->max_x = j;
+                    if (i < m->min_y) m->min_y = i;
+                    if (i > m->max_y) m->max_y = i;
+                }
+            }
+        }
+    }
+}
+
+/* --- Randomizer --- */
+
+/* splitmix64: tiny, fast and good enough for shuffling a bag */
+uint32_t next_random(TetrisGame *g) {
+    uint64_t z = (g->rng += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+void shuffle_bag(TetrisGame *g) {
+    for (int i = 0; i < 7; i++) g->bag[i] = i;
+    for (int i = 6; i > 0; i--) {
+        int j = next_random(g) % (i + 1);
+        int temp = g->bag[i];
+        g->bag[i] = g->bag[j];
+        g->bag[j] = temp;
+    }
+    g->bag_ptr = 0;
+}
+
+int next_from_bag(TetrisGame *g) {
+    if (g->bag_ptr >= 7) shuffle_bag(g);
+    return g->bag[g->bag_ptr++];
+}
+
+/* --- Game State --- */
+
+void init_game(TetrisGame *g, uint64_t seed, long now) {
+    init_game_size(g, BOARD_WIDTH, BOARD_HEIGHT, seed, now);
+}
+
+void init_game_size(TetrisGame *g, int width, int height, uint64_t seed, long now) {
+    memset(g, 0, sizeof(*g));
+    g->board.width = width;
+    g->board.height = height;
+    g->board.full = row_full(width);
+    g->board.rows = calloc(height, sizeof(RowMask));
+    g->colors = calloc((size_t)width * height, 1);
+
+    g->seed = seed;
+    g->rng = seed;
+    g->drop_rate = DROP_RATE_INITIAL;
+    g->hold_type = -1;
+    g->can_hold = 1;
+    g->lock_timer = NO_TIMER;
+
+    shuffle_bag(g);
+    g->next_type = next_from_bag(g);
+    new_piece(g, now);
+    g->last_drop_time = now;
+}
+
+void free_game(TetrisGame *g) {
+    free(g->board.rows);
+    free(g->colors);
+    g->board.rows = NULL;
+    g->colors = NULL;
+}
+
+static int stack_top(const TetrisGame *g);
+
+void copy_game(TetrisGame *dst, const TetrisGame *src) {
+    const Board *b = &src->board;
+    size_t w = b->width;
+    RowMask *rows = dst->board.rows;
+    unsigned char *colors = dst->colors;
+
+    /* Rows above both stacks are empty in both boards */
+    int top = stack_top(src);
+    if (rows && dst->board.width == b->width && dst->board.height == b->height) {
+        int dst_top = stack_top(dst);
+        if (dst_top < top) top = dst_top;
+    } else {
+        free(rows);
+        free(colors);
+        rows = calloc(b->height, sizeof(RowMask));
+        colors = calloc(w * b->height, 1);
+    }
+
+    *dst = *src;
+    dst->board.rows = rows;
+    dst->colors = colors;
+    memcpy(rows + top, b->rows + top, sizeof(RowMask) * (b->height - top));
+    memcpy(colors + top * w, src->colors + top * w, w * (b->height - top));
+}
+
+/* Place a piece row at board column px. Callers bounds-check px first,
+   so no occupied bit is shifted out. */
+static inline RowMask shift_row(RowMask row, int px) {
+    return px >= 0 ? row << px : row >> -px;
+}
+
+int collides(const Board *b, int type, int px, int py, int prot) {
+    const PieceMask *m = &piece_masks[type][prot];
+    if (px + m->min_x < 0 || px + m->max_x >= b->width) return 1;
+    if (py + m->max_y >= b->height) return 1;
+
+    for (int i = m->min_y; i <= m->max_y; i++) {
+        int by = py + i;
+        if (by >= 0 && (b->rows[by] & shift_row(m->rows[i], px))) return 1;
+    }
+    return 0;
+}
+
+int check_collision(const TetrisGame *g, int type, int px, int py, int prot) {
+    return collides(&g->board, type, px, py, prot);
+}
+
+/* Heights from a top-down scan starting at row `from`, above which the
+   board is known to be empty. Stops once every column has been seen. */
+static void scan_heights(const Board *b, int from, int *heights) {
+    RowMask seen = 0;
+    memset(heights, 0, sizeof(int) * b->width);
+    for (int y = from; y < b->height && seen != b->full; y++) {
+        RowMask fresh = b->rows[y] & ~seen;
+        seen |= fresh;
+        while (fresh) {
+            heights[__builtin_ctzll(fresh)] = b->height - y;
+            fresh &= fresh - 1;
+        }
+    }
+}
+
+void column_heights(const Board *b, int *heights) {
+    scan_heights(b, 0, heights);
+}
+
+/* Highest row the piece's bottom profile can sit at on top of the stack.
+   Only meaningful while the piece is above the surface in every column. */
+static int surface_y(const Board *b, const int *heights, const PieceMask *m, int px) {
+    int land = b->height;
+    for (int j = m->min_x; j <= m->max_x; j++) {
+        int y = b->height - heights[px + j] - 1 - m->bottom[j];
+        if (y < land) land = y;
+    }
+    return land;
+}
+
+int landing_y(const Board *b, const int *heights, int type, int px, int py, int prot) {
+    int land = surface_y(b, heights, &piece_masks[type][prot], px);
+    if (land >= py) return land;
+
+    /* Below the surface of some column, i.e. under an overhang */
+    while (!collides(b, type, px, py + 1, prot)) py++;
+    return py;
+}
+
+int is_grounded(const TetrisGame *g) {
+    const Tetromino *p = &g->current;
+    int land = surface_y(&g->board, g->heights, &piece_masks[p->type][p->rotation], p->x);
+    if (land >= p->y) return land == p->y;
+    return check_collision(g, p->type, p->x, p->y + 1, p->rotation);
+}
+
+int ghost_y(const TetrisGame *g) {
+    const Tetromino *p = &g->current;
+    return landing_y(&g->board, g->heights, p->type, p->x, p->y, p->rotation);
+}
+
+/* First row holding a block; the board's height when empty. */
+static int stack_top(const TetrisGame *g) {
+    int top = 0;
+    for (int x = 0; x < g->board.width; x++) {
+        if (g->heights[x] > top) top = g->heights[x];
+    }
+    return g->board.height - top;
+}
+
+/* Re-evaluate lock delay after the piece changed position at `now`.
+   `reset` restarts a running timer (move reset); otherwise a running
+   timer is kept. */
+static void update_lock_timer(TetrisGame *g, long now, int reset) {
+    if (is_grounded(g)) {
+        if (g->lock_timer == NO_TIMER || reset) g->lock_timer = now;
+    } else {
+        g->lock_timer = NO_TIMER;
+    }
+}
+
+void spawn_piece(TetrisGame *g, int type, long now) {
+    Tetromino *p = &g->current;
+    p->type = type;
+    p->x = (g->board.width - SHAPES[type].grid_size) / 2;
+    p->y = 0;
+    p->rotation = 0;
+    p->color = SHAPES[type].color;
+
+    if (check_collision(g, type, p->x, p->y, p->rotation)) {
+        g->game_over = 1;
+    }
+
+    g->lock_timer = NO_TIMER; /* Reset lock timer on spawn */
+    update_lock_timer(g, now, 0);
+}
+
+void new_piece(TetrisGame *g, long now) {
+    spawn_piece(g, g->next_type, now);
+    g->next_type = next_from_bag(g);
+    g->can_hold = 1;
+}
+
+void hold_piece(TetrisGame *g, long now) {
+    if (!g->can_hold) return;
+
+    if (g->hold_type == -1) {
+        g->hold_type = g->current.type;
+        new_piece(g, now);
+    } else {
+        int temp = g->hold_type;
+        g->hold_type = g->current.type;
+        spawn_piece(g, temp, now);
+    }
+
+    g->can_hold = 0;
+}
+
+static int clear_range(TetrisGame *g, int lo, int hi);
+
+void lock_piece(TetrisGame *g, long now) {
+    const Tetromino *p = &g->current;
+    const PieceMask *m = &piece_masks[p->type][p->rotation];
+    Board *b = &g->board;
+    for (int i = m->min_y; i <= m->max_y; i++) {
+        int by = p->y + i;
+        if (by < 0 || by >= b->height) continue;
+        RowMask bits = shift_row(m->rows[i], p->x) & b->full;
+        b->rows[by] |= bits;
+        unsigned char *colors = g->colors + (size_t)by * b->width;
+        while (bits) {
+            colors[__builtin_ctzll(bits)] = p->color;
+            bits &= bits - 1;
+        }
+    }
+    for (int j = m->min_x; j <= m->max_x; j++) {
+        /* Cells above the board were dropped along with their rows */
+        int top = p->y + m->top[j];
+        if (p->y + m->bottom[j] < 0) continue;
+        if (top < 0) top = 0;
+        if (b->height - top > g->heights[p->x + j]) g->heights[p->x + j] = b->height - top;
+    }
+    g->pieces++;
+    g->last_locked = *p;
+
+    /* Only the rows the piece landed in can have filled up */
+    int lo = p->y + m->min_y, hi = p->y + m->max_y;
+    clear_range(g, lo < 0 ? 0 : lo, hi < b->height ? hi : b->height - 1);
+    new_piece(g, now);
+}
+
+int clear_lines(TetrisGame *g) {
+    return clear_range(g, 0, g->board.height - 1);
+}
+
+/* Garbage rows sent for clearing 0..4 lines at once */
+static const int GARBAGE_SENT[5] = { 0, 0, 1, 2, 4 };
+
+/* Remove the full rows among lo..hi and drop the stack above them. Work
+   is proportional to the stack above `hi`, not to the board height. */
+static int clear_range(TetrisGame *g, int lo, int hi) {
+    Board *b = &g->board;
+    size_t w = b->width;
+    int top = stack_top(g);
+    if (lo < top) lo = top;
+
+    int lines_cleared = 0;
+    for (int y = lo; y <= hi; y++) lines_cleared += b->rows[y] == b->full;
+    if (lines_cleared == 0) return 0;
+
+    /* Compact non-full rows towards the bottom in a single pass */
+    int dst = hi;
+    for (int y = hi; y >= top; y--) {
+        if (y >= lo && b->rows[y] == b->full) continue;
+        if (dst != y) {
+            b->rows[dst] = b->rows[y];
+            memcpy(g->colors + dst * w, g->colors + y * w, w);
+        }
+        dst--;
+    }
+    for (int y = dst; y >= top; y--) {
+        b->rows[y] = 0;
+        memset(g->colors + y * w, 0, w);
+    }
+    /* A cleared row can uncover an overhang, so rescan rather than
+       just subtracting */
+    scan_heights(b, top + lines_cleared, g->heights);
+    g->lines += lines_cleared;
+
+    /* Award points based on lines cleared */
+    switch (lines_cleared) {
+        case 1: g->score += 100; break;
+        case 2: g->score += 300; break;
+        case 3: g->score += 500; break;
+        case 4: g->score += 800; break;
+    }
+    g->attack += GARBAGE_SENT[lines_cleared < 4 ? lines_cleared : 4];
+
+    /* Check for all-clear (perfect clear) bonus */
+    if (stack_top(g) == b->height) {
+        g->score += 3000; /* All-clear bonus! */
+    }
+
+    if (g->drop_rate > 100000) g->drop_rate -= 10000;
+    return lines_cleared;
+}
+
+void add_garbage(TetrisGame *g, int rows, int hole) {
+    Board *b = &g->board;
+    size_t w = b->width;
+    if (rows <= 0) return;
+    if (rows > b->height) rows = b->height;
+
+    /* Rows [top, height) move up by `rows`; any that would leave the
+       board are lost */
+    int top = stack_top(g);
+    int from = top < rows ? rows : top;
+    if (top < rows) g->game_over = 1;
+    memmove(b->rows + from - rows, b->rows + from, sizeof(RowMask) * (b->height - from));
+    memmove(g->colors + (from - rows) * w, g->colors + from * w, w * (b->height - from));
+
+    RowMask row = b->full & ~((RowMask)1 << hole);
+    for (int y = b->height - rows; y < b->height; y++) {
+        b->rows[y] = row;
+        memset(g->colors + y * w, GARBAGE_COLOR, w);
+        g->colors[y * w + hole] = 0;
+    }
+    scan_heights(b, from - rows, g->heights);
+
+    Tetromino *p = &g->current;
+    int lifted = 0;
+    while (lifted < rows && check_collision(g, p->type, p->x, p->y, p->rotation)) {
+        p->y--;
+        lifted++;
+    }
+    if (check_collision(g, p->type, p->x, p->y, p->rotation)) g->game_over = 1;
+}
+
+int move_piece(TetrisGame *g, int dx, int dy, long now) {
+    Tetromino *p = &g->current;
+    if (check_collision(g, p->type, p->x + dx, p->y + dy, p->rotation)) return 0;
+
+    p->x += dx;
+    p->y += dy;
+    /* Only lateral moves reset a running lock timer (infinite move reset);
+       a soft drop must not stall the lock. */
+    update_lock_timer(g, now, dx != 0);
+    return 1;
+}
+
+int kick_rotate(const Board *b, Tetromino *p, int dir) {
+    int old_rot = p->rotation;
+    int new_rot = (old_rot + 4 + dir) % 4;
+    int kick_idx = get_kick_index(old_rot, new_rot);
+    const int (*kicks)[2] = NULL;
+
+    /* Type 0 = I, Type 3 = O, Others = JLSTZ */
+    if (p->type == 0) {
+        kicks = KICKS_I[kick_idx];
+    } else if (p->type == 3) {
+        /* O piece rotates but no kicks */
+        kicks = NULL;
+    } else {
+        kicks = KICKS_JLSTZ[kick_idx];
+    }
+
+    /* Basic Rotation + 5 SRS Tests */
+    for (int i = 0; i < 5; i++) {
+        int dx = 0, dy = 0;
+        if (kicks) {
+            dx = kicks[i][0];
+            dy = kicks[i][1];
+        } else {
+            /* If no kicks (O piece), only test 0 */
+            if (i > 0) break;
+        }
+
+        if (!collides(b, p->type, p->x + dx, p->y + dy, new_rot)) {
+            p->x += dx;
+            p->y += dy;
+            p->rotation = new_rot;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int rotate_piece(TetrisGame *g, int dir, long now) {
+    if (!kick_rotate(&g->board, &g->current, dir)) return 0;
+    update_lock_timer(g, now, 1);
+    return 1;
+}
+
+void hard_drop(TetrisGame *g, long now) {
+    g->current.y = ghost_y(g);
+    lock_piece(g, now);
+    g->last_drop_time = now;
+}
+
+int apply_input(TetrisGame *g, int input, long now) {
+    switch (input) {
+        case INPUT_LEFT:       return move_piece(g, -1, 0, now);
+        case INPUT_RIGHT:      return move_piece(g, 1, 0, now);
+        case INPUT_SOFT_DROP:  return move_piece(g, 0, 1, now);
+        case INPUT_ROTATE_CW:  return rotate_piece(g, 1, now);
+        case INPUT_ROTATE_CCW: return rotate_piece(g, -1, now);
+        case INPUT_HARD_DROP:  hard_drop(g, now); return 1;
+        case INPUT_HOLD:
+            if (!g->can_hold) return 0;
+            hold_piece(g, now);
+            return 1;
+    }
+    return 0;
+}
+
+long next_deadline(const TetrisGame *g) {
+    if (g->game_over) return LONG_MAX;
+    long gravity_at = g->last_drop_time + g->drop_rate;
+    long lock_at = g->lock_timer == NO_TIMER ? LONG_MAX : g->lock_timer + LOCK_DELAY;
+    return lock_at < gravity_at ? lock_at : gravity_at;
+}
+
+void update_game(TetrisGame *g, long now) {
+    while (!g->game_over) {
+        long gravity_at = g->last_drop_time + g->drop_rate;
+        long lock_at = g->lock_timer == NO_TIMER ? LONG_MAX : g->lock_timer + LOCK_DELAY;
+
+        if (lock_at <= gravity_at && lock_at <= now) {
+            lock_piece(g, lock_at);
+        } else if (gravity_at <= now) {
+            /* Gravity Logic */
+            g->last_drop_time = gravity_at;
+            if (g->lock_timer == NO_TIMER) {
+                g->current.y++;
+                update_lock_timer(g, gravity_at, 0);
+            }
+        } else {
+            break;
+        }
+    }
+}
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t len) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001B3ULL;
+    }
+    return h;
+}
+
+uint64_t board_hash(const TetrisGame *g) {
+    int pieces[6] = { g->current.type, g->current.x, g->current.y,
+                      g->current.rotation, g->hold_type, g->next_type };
+    uint64_t h = 0xCBF29CE484222325ULL;
+    h = fnv1a(h, g->board.rows, sizeof(RowMask) * g->board.height);
+    h = fnv1a(h, g->colors, (size_t)g->board.width * g->board.height);
+    return fnv1a(h, pieces, sizeof(pieces));
+}
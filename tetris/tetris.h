@@ -0,0 +1,185 @@
+#ifndef TETRIS_H
+#define TETRIS_H
+
+/*
+ * Headless Tetris rules engine.
+ *
+ * All state lives in a TetrisGame and nothing here touches the terminal or
+ * the wall clock: every entry point takes the current time in microseconds
+ * from the caller, so the same seed and the same timestamped inputs always
+ * produce the same game. The ncurses front end in main.c is one client,
+ * bench.c is another.
+ */
+
+#include <stdint.h>
+
+/* Constants */
+#define DROP_RATE_INITIAL 500000
+#define LOCK_DELAY 500000   /* 0.5s lock delay */
+
+/* Default board size; init_game_size() takes any size up to the maximum */
+#define BOARD_WIDTH 10
+#define BOARD_HEIGHT 20
+#define BOARD_MAX_WIDTH 64
+#define BOARD_MAX_HEIGHT 16384
+
+#define NO_TIMER -1         /* lock_timer value while the piece is airborne */
+#define GARBAGE_COLOR 9     /* color pair of garbage cells */
+
+/* One bit per column, bit x = column x, so a row of any width up to 64 is
+   a single word. */
+typedef uint64_t RowMask;
+
+static inline RowMask row_full(int width) {
+    return width >= 64 ? ~(RowMask)0 : (((RowMask)1) << width) - 1;
+}
+
+/* Board geometry and occupancy: everything the rule checks look at. The
+   rows may belong to a TetrisGame or be any caller's scratch copy. */
+typedef struct {
+    int width, height;
+    RowMask full;       /* a complete row, row_full(width) */
+    RowMask *rows;      /* `height` rows, row 0 at the top */
+} Board;
+
+/* Player inputs. These are also the event codes stored in replays, so
+   only ever append. */
+enum {
+    INPUT_LEFT,
+    INPUT_RIGHT,
+    INPUT_SOFT_DROP,
+    INPUT_ROTATE_CW,
+    INPUT_ROTATE_CCW,
+    INPUT_HARD_DROP,
+    INPUT_HOLD,
+    INPUT_COUNT
+};
+
+/* Structs */
+typedef struct {
+    int shape[4][4];
+    int color;
+    int grid_size; /* 2, 3, or 4 */
+} TetrominoDef;
+
+typedef struct {
+    int x;
+    int y;
+    int type;
+    int rotation;  /* 0..3 */
+    int color;
+} Tetromino;
+
+/* Precomputed occupancy of one piece type in one rotation. */
+typedef struct {
+    RowMask rows[4];   /* row i of the bounding box, bit j = local column j */
+    int min_x, max_x;  /* occupied local column range */
+    int min_y, max_y;  /* occupied local row range */
+    int top[4];        /* per local column, highest occupied local row, -1 if empty */
+    int bottom[4];     /* per local column, lowest occupied local row, -1 if empty */
+} PieceMask;
+
+typedef struct {
+    Board board;                    /* occupancy, used by all rule checks */
+    unsigned char *colors;          /* color pair per cell, row-major, for drawing only */
+    int heights[BOARD_MAX_WIDTH];   /* per column, rows up to the highest block */
+
+    Tetromino current;
+    Tetromino last_locked;  /* where the previous piece came to rest */
+    int next_type;
+    int hold_type;      /* -1 means empty */
+    int can_hold;
+
+    /* Randomizer State */
+    int bag[7];
+    int bag_ptr;
+    uint64_t seed;      /* seed passed to init_game(), kept for replays */
+    uint64_t rng;
+
+    int score;
+    int lines;
+    int pieces;
+    int attack;         /* garbage rows earned by clears, for the caller to send */
+    int game_over;
+
+    /* Timers, all in caller-supplied microseconds */
+    long drop_rate;
+    long last_drop_time;
+    long lock_timer;    /* time the piece touched down, NO_TIMER if airborne */
+} TetrisGame;
+
+extern const TetrominoDef SHAPES[7];
+extern PieceMask piece_masks[7][4];
+
+/* Must be called once before any other function. */
+void init_piece_masks(void);
+
+/* Start a game on the default board. Allocates the board, so a game must
+   be released with free_game() before it is initialized again. */
+void init_game(TetrisGame *g, uint64_t seed, long now);
+/* Same on a width x height board, width <= BOARD_MAX_WIDTH and
+   height <= BOARD_MAX_HEIGHT. */
+void init_game_size(TetrisGame *g, int width, int height, uint64_t seed, long now);
+void free_game(TetrisGame *g);
+
+/* Make `dst` an exact copy of `src`, reusing dst's board when it has the
+   same size. dst must be zeroed or hold a game. Only rows at or below
+   either stack are copied, so this is cheap enough for per-frame
+   snapshots. */
+void copy_game(TetrisGame *dst, const TetrisGame *src);
+
+uint32_t next_random(TetrisGame *g);
+void shuffle_bag(TetrisGame *g);
+int next_from_bag(TetrisGame *g);
+
+void spawn_piece(TetrisGame *g, int type, long now);
+void new_piece(TetrisGame *g, long now);
+int collides(const Board *b, int type, int px, int py, int prot);
+int check_collision(const TetrisGame *g, int type, int px, int py, int prot);
+int is_grounded(const TetrisGame *g);
+int ghost_y(const TetrisGame *g);
+
+/* Fill heights[b->width] with each column's height, counted from the
+   floor to its highest block. */
+void column_heights(const Board *b, int *heights);
+
+/* Row where a piece at (px, py) comes to rest when dropped. Constant time
+   against the column heights while the piece is above the stack; falls
+   back to stepping through the rows when it is tucked under an overhang. */
+int landing_y(const Board *b, const int *heights, int type, int px, int py, int prot);
+
+/* Rotate `p` by dir (+1 cw, -1 ccw) using the SRS kick tables.
+   Returns 1 and updates `p` if one of the kick tests fits. */
+int kick_rotate(const Board *b, Tetromino *p, int dir);
+
+/* Player actions. move_piece/rotate_piece return 1 if the piece moved. */
+int move_piece(TetrisGame *g, int dx, int dy, long now);
+int rotate_piece(TetrisGame *g, int dir, long now);
+void hard_drop(TetrisGame *g, long now);
+void hold_piece(TetrisGame *g, long now);
+
+/* Dispatch one INPUT_* to the matching action. Returns 1 if the game
+   state changed. */
+int apply_input(TetrisGame *g, int input, long now);
+
+void lock_piece(TetrisGame *g, long now);
+int clear_lines(TetrisGame *g);
+
+/* Push the stack up by `rows` garbage rows, each full except for column
+   `hole`. The active piece is lifted out of the way if it can be; blocks
+   pushed off the top, or a piece with nowhere to go, end the game. */
+void add_garbage(TetrisGame *g, int rows, int hole);
+
+/* Apply gravity and lock delay up to `now`. Deadlines are processed in
+   time order at their exact due time, so the result does not depend on
+   how often this is called. */
+void update_game(TetrisGame *g, long now);
+
+/* Time of the next gravity step or lock, whichever is first; LONG_MAX once
+   the game is over. A front end can sleep until then. */
+long next_deadline(const TetrisGame *g);
+
+/* FNV-1a hash of the board, the active piece and the hold/next pieces. */
+uint64_t board_hash(const TetrisGame *g);
+
+#endif
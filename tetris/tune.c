@@ -0,0 +1,383 @@
+#define _POSIX_C_SOURCE 199309L
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bot.h"
+#include "pool.h"
+#include "tetris.h"
+
+/*
+ * Genetic tuner for the bot's evaluation weights.
+ *
+ * Every generation each candidate plays the same seeded 7-bag games with
+ * the one-ply greedy bot, and its fitness is the average number of lines
+ * cleared before top-out or the piece cap. Strong candidates all reach the
+ * cap's line count, so ties go to the lower average stack left at the end.
+ * Games are dealt to the work-stealing pool in batches, so every core
+ * stays busy until the last batch of the generation. The best half
+ * survives; the rest are bred from tournament winners with blend
+ * crossover and gaussian mutation.
+ *
+ * After every generation the population is checkpointed, and a run
+ * pointed at an existing checkpoint picks up where it stopped. The best
+ * candidate of the latest generation is written in the format
+ * `tetris --weights` loads.
+ *
+ *   ./tetris_tune [--threads N] [--population N] [--games N] [--pieces N]
+ *                 [--generations N] [--seed N] [--checkpoint FILE] [--out FILE]
+ */
+
+#define MAX_POPULATION 256
+#define MAX_GAMES 100000        /* per candidate per generation */
+#define BATCH_GAMES 8           /* games per pool task */
+#define GENES 5
+#define TOURNAMENT 3
+#define MUTATION_RATE 0.3       /* chance per gene */
+#define MUTATION_SIGMA 0.2      /* of the unit-length weight vector */
+
+typedef struct {
+    double genes[GENES];
+    double fitness;             /* average lines */
+    double stack;               /* average final stack height, the tie-break */
+} Candidate;
+
+/* One batch of games for one candidate. Padded so workers finishing
+   neighbouring tasks do not share a cache line. */
+typedef struct {
+    Candidate *candidate;
+    int first_game, count;
+    long lines, pieces, stack;
+    char pad[64];
+} Task;
+
+static int population = 32;
+static int games = 256;
+static int max_pieces = 500;
+static int generations = 20;
+static uint64_t seed = 1;
+static const char *checkpoint_path = "tune.ckpt";
+static const char *out_path = "tuned.weights";
+
+static Candidate pop[MAX_POPULATION];
+static Task *tasks;             /* population x batches, allocated once settings are known */
+static int generation = 0;
+static uint64_t rng;            /* selection, crossover and mutation */
+
+static double now_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* splitmix64, same as the games' own randomizer */
+static uint64_t random64(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double random_unit() {
+    return (random64(&rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double random_gaussian() {
+    double u = random_unit(), v = random_unit();
+    return sqrt(-2.0 * log(u + 1e-300)) * cos(6.283185307179586 * v);
+}
+
+static void to_weights(const double *genes, BotWeights *w) {
+    w->height = genes[0];
+    w->lines = genes[1];
+    w->holes = genes[2];
+    w->bumpiness = genes[3];
+    w->wells = genes[4];
+}
+
+static void from_weights(const BotWeights *w, double *genes) {
+    genes[0] = w->height;
+    genes[1] = w->lines;
+    genes[2] = w->holes;
+    genes[3] = w->bumpiness;
+    genes[4] = w->wells;
+}
+
+/* Only the direction of the weight vector matters to the bot */
+static void normalize(double *genes) {
+    double len = 0;
+    for (int i = 0; i < GENES; i++) len += genes[i] * genes[i];
+    len = sqrt(len);
+    if (len == 0) {
+        genes[0] = -1;
+        return;
+    }
+    for (int i = 0; i < GENES; i++) genes[i] /= len;
+}
+
+/* --- Evaluation --- */
+
+/* Seed of game `index` in the current generation, shared by all candidates */
+static uint64_t game_seed(int index) {
+    uint64_t s = seed ^ ((uint64_t)generation << 32) ^ (uint64_t)index;
+    return random64(&s);
+}
+
+static void play_batch(void *arg) {
+    Task *t = arg;
+    BotWeights w;
+    to_weights(t->candidate->genes, &w);
+
+    TetrisGame g;
+    memset(&g, 0, sizeof(g));
+    t->lines = t->pieces = t->stack = 0;
+    for (int i = 0; i < t->count; i++) {
+        free_game(&g);
+        init_game(&g, game_seed(t->first_game + i), 0);
+        while (!g.game_over && g.pieces < max_pieces) {
+            int use_hold;
+            Tetromino target;
+            if (!bot_greedy(&w, &g, &use_hold, &target)) break;
+            if (use_hold) hold_piece(&g, 0);
+            g.current = target;
+            lock_piece(&g, 0);
+        }
+        t->lines += g.lines;
+        t->pieces += g.pieces;
+        int top = 0;
+        for (int x = 0; x < g.board.width; x++) {
+            if (g.heights[x] > top) top = g.heights[x];
+        }
+        t->stack += g.game_over ? g.board.height : top;
+    }
+    free_game(&g);
+}
+
+/* Measure every candidate. Returns games played. */
+static long evaluate(ThreadPool *pool, long *pieces) {
+    int batches = (games + BATCH_GAMES - 1) / BATCH_GAMES;
+    int n = 0;
+    for (int c = 0; c < population; c++) {
+        for (int b = 0; b < batches; b++) {
+            Task *t = &tasks[n++];
+            t->candidate = &pop[c];
+            t->first_game = b * BATCH_GAMES;
+            t->count = games - t->first_game < BATCH_GAMES ? games - t->first_game : BATCH_GAMES;
+            pool_submit(pool, play_batch, t);
+        }
+    }
+    pool_wait(pool);
+
+    long played = 0;
+    *pieces = 0;
+    for (int i = 0; i < n; i += batches) {
+        long lines = 0, stack = 0;
+        for (int b = 0; b < batches; b++) {
+            lines += tasks[i + b].lines;
+            stack += tasks[i + b].stack;
+            *pieces += tasks[i + b].pieces;
+        }
+        tasks[i].candidate->fitness = (double)lines / games;
+        tasks[i].candidate->stack = (double)stack / games;
+        played += games;
+    }
+    return played;
+}
+
+/* --- Breeding --- */
+
+static int better(const Candidate *a, const Candidate *b) {
+    if (a->fitness != b->fitness) return a->fitness > b->fitness;
+    return a->stack < b->stack;
+}
+
+static int by_fitness(const void *a, const void *b) {
+    return better(b, a) - better(a, b);
+}
+
+static const Candidate *tournament(int pool_size) {
+    const Candidate *best = NULL;
+    for (int i = 0; i < TOURNAMENT; i++) {
+        const Candidate *c = &pop[random64(&rng) % pool_size];
+        if (!best || better(c, best)) best = c;
+    }
+    return best;
+}
+
+/* Keep the better half (pop is sorted) and replace the rest with children
+   of parents drawn from it. */
+static void breed() {
+    int elite = (population + 1) / 2;
+    for (int i = elite; i < population; i++) {
+        const Candidate *a = tournament(elite), *b = tournament(elite);
+        double mix = random_unit();
+        Candidate *child = &pop[i];
+        for (int k = 0; k < GENES; k++) {
+            child->genes[k] = mix * a->genes[k] + (1 - mix) * b->genes[k];
+            if (random_unit() < MUTATION_RATE) child->genes[k] += MUTATION_SIGMA * random_gaussian();
+        }
+        normalize(child->genes);
+    }
+}
+
+/* Start from the default weights plus random directions */
+static void init_population() {
+    rng = seed;
+    for (int i = 0; i < population; i++) {
+        if (i == 0) {
+            from_weights(&BOT_DEFAULT_WEIGHTS, pop[i].genes);
+        } else {
+            for (int k = 0; k < GENES; k++) pop[i].genes[k] = random_unit() * 2 - 1;
+        }
+        normalize(pop[i].genes);
+    }
+}
+
+/* --- Checkpoints --- */
+
+/* Written to a temporary file and renamed into place, so an interrupted
+   run always leaves the previous checkpoint intact. Holds the population
+   after breeding, i.e. ready for the next generation. */
+static int save_checkpoint() {
+    char tmp[1024];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", checkpoint_path);
+    FILE *f = fopen(tmp, "w");
+    if (!f) return 0;
+    fprintf(f, "tetris_tune 1\n");
+    fprintf(f, "%d %d %d %d %llu %llu\n", generation, population, games, max_pieces,
+            (unsigned long long)seed, (unsigned long long)rng);
+    for (int i = 0; i < population; i++) {
+        for (int k = 0; k < GENES; k++) fprintf(f, "%.17g%c", pop[i].genes[k], k + 1 < GENES ? ' ' : '\n');
+    }
+    if (fclose(f) != 0) return 0;
+    return rename(tmp, checkpoint_path) == 0;
+}
+
+/* The same limits hold for the command line and a checkpoint */
+static int valid_settings() {
+    return population > 1 && population <= MAX_POPULATION && games > 0 && games <= MAX_GAMES &&
+           max_pieces > 0;
+}
+
+/* Returns 1 if resumed, 0 if there is no checkpoint, -1 if it is bad. */
+static int load_checkpoint() {
+    FILE *f = fopen(checkpoint_path, "r");
+    if (!f) return 0;
+
+    unsigned long long s, r;
+    int version, ok = fscanf(f, "tetris_tune %d %d %d %d %d %llu %llu", &version, &generation,
+                             &population, &games, &max_pieces, &s, &r) == 7 &&
+                      version == 1 && valid_settings();
+    for (int i = 0; ok && i < population; i++) {
+        for (int k = 0; ok && k < GENES; k++) ok = fscanf(f, "%lf", &pop[i].genes[k]) == 1;
+    }
+    fclose(f);
+    seed = s;
+    rng = r;
+    return ok ? 1 : -1;
+}
+
+static void save_best(const Candidate *best) {
+    BotWeights w;
+    char comment[128];
+    to_weights(best->genes, &w);
+    snprintf(comment, sizeof(comment), "tetris_tune generation %d: %.1f lines over %d games of %d pieces",
+             generation, best->fitness, games, max_pieces);
+    if (!bot_save_weights(&w, out_path, comment)) fprintf(stderr, "%s: cannot write weights\n", out_path);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [--threads N] [--population N] [--games N] [--pieces N]\n"
+                    "       %*s [--generations N] [--seed N] [--checkpoint FILE] [--out FILE]\n",
+            prog, (int)strlen(prog), "");
+    fprintf(stderr, "  --threads N       worker threads (default: one per CPU)\n");
+    fprintf(stderr, "  --population N    candidates per generation, up to %d (default 32)\n", MAX_POPULATION);
+    fprintf(stderr, "  --games N         games per candidate per generation, up to %d (default 256)\n", MAX_GAMES);
+    fprintf(stderr, "  --pieces N        end each game after N pieces (default 500)\n");
+    fprintf(stderr, "  --generations N   stop after generation N (default 20)\n");
+    fprintf(stderr, "  --seed N          seed for a new run (default 1)\n");
+    fprintf(stderr, "  --checkpoint FILE resume from and save to FILE (default tune.ckpt)\n");
+    fprintf(stderr, "  --out FILE        write the best weights to FILE (default tuned.weights)\n");
+    fprintf(stderr, "The population settings and seed of a resumed run come from its checkpoint.\n");
+}
+
+int main(int argc, char **argv) {
+    int threads = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--population") == 0 && i + 1 < argc) {
+            population = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            games = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pieces") == 0 && i + 1 < argc) {
+            max_pieces = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--generations") == 0 && i + 1 < argc) {
+            generations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            checkpoint_path = argv[++i];
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!valid_settings()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    init_piece_masks();
+    int resumed = load_checkpoint();
+    if (resumed < 0) {
+        fprintf(stderr, "%s: not a valid checkpoint\n", checkpoint_path);
+        return 1;
+    }
+    if (resumed) {
+        printf("Resuming %s at generation %d\n", checkpoint_path, generation);
+    } else {
+        init_population();
+    }
+    int batches = (games + BATCH_GAMES - 1) / BATCH_GAMES;
+    tasks = calloc((size_t)population * batches, sizeof(Task));
+
+    ThreadPool *pool = pool_create(threads);
+    int cores = pool_size(pool);
+    printf("%d candidates x %d games of up to %d pieces on %d threads\n",
+           population, games, max_pieces, cores);
+    printf("  gen   best lines  stack   mean lines    games/s  games/s/core   pieces/s\n");
+
+    while (generation < generations) {
+        double start = now_seconds();
+        long pieces;
+        long played = evaluate(pool, &pieces);
+        double secs = now_seconds() - start;
+
+        qsort(pop, population, sizeof(Candidate), by_fitness);
+        double mean = 0;
+        for (int i = 0; i < population; i++) mean += pop[i].fitness;
+        mean /= population;
+
+        generation++;
+        printf("%5d %12.1f %6.1f %12.1f %10.0f %13.1f %10.0f\n", generation, pop[0].fitness,
+               pop[0].stack, mean,
+               played / secs, played / secs / cores, pieces / secs);
+        fflush(stdout);
+        save_best(&pop[0]);
+
+        /* Survivors are re-measured on the next generation's games, so
+           luck on one set of seeds does not carry over */
+        breed();
+        if (!save_checkpoint()) fprintf(stderr, "%s: cannot write checkpoint\n", checkpoint_path);
+    }
+
+    pool_destroy(pool);
+    free(tasks);
+    printf("Best weights in %s\n", out_path);
+    return 0;
+}
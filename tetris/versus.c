@@ -0,0 +1,145 @@
+#include "versus.h"
+
+#include <string.h>
+
+/* --- Versus --- */
+
+/* splitmix64, same as the games' own randomizer */
+static uint32_t garbage_random(Versus *v) {
+    uint64_t z = (v->rng += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+void versus_init(Versus *v, uint64_t seed, int width, int height) {
+    memset(v, 0, sizeof(*v));
+    for (int p = 0; p < 2; p++) init_game_size(&v->games[p], width, height, seed, 0);
+    v->rng = seed ^ 0x6A09E667F3BCC909ULL;
+}
+
+void versus_free(Versus *v) {
+    for (int p = 0; p < 2; p++) free_game(&v->games[p]);
+}
+
+void versus_copy(Versus *dst, const Versus *src) {
+    for (int p = 0; p < 2; p++) copy_game(&dst->games[p], &src->games[p]);
+    dst->incoming[0] = src->incoming[0];
+    dst->incoming[1] = src->incoming[1];
+    dst->rng = src->rng;
+    dst->frame = src->frame;
+}
+
+int versus_winner(const Versus *v) {
+    int over0 = v->games[0].game_over, over1 = v->games[1].game_over;
+    if (over0 && over1) return 2;
+    if (over0) return 1;
+    if (over1) return 0;
+    return -1;
+}
+
+void versus_step(Versus *v, const uint8_t inputs[2]) {
+    long now = (long)v->frame * VERSUS_FRAME_US;
+    v->frame++;
+    if (versus_winner(v) != -1) return;
+
+    int pieces[2], lines[2];
+    for (int p = 0; p < 2; p++) {
+        TetrisGame *g = &v->games[p];
+        pieces[p] = g->pieces;
+        lines[p] = g->lines;
+        update_game(g, now);
+        for (int i = 0; i < INPUT_COUNT && !g->game_over; i++) {
+            if ((inputs[p] >> i) & 1) apply_input(g, i, now);
+        }
+    }
+
+    /* Clears cancel the sender's own incoming rows before the rest is
+       passed on */
+    for (int p = 0; p < 2; p++) {
+        TetrisGame *g = &v->games[p];
+        int cancel = g->attack < v->incoming[p] ? g->attack : v->incoming[p];
+        v->incoming[p] -= cancel;
+        v->incoming[1 - p] += g->attack - cancel;
+        g->attack = 0;
+    }
+
+    /* Garbage rises when a piece locks without clearing */
+    for (int p = 0; p < 2; p++) {
+        TetrisGame *g = &v->games[p];
+        if (g->game_over || !v->incoming[p]) continue;
+        if (g->pieces == pieces[p] || g->lines != lines[p]) continue;
+        int rows = v->incoming[p] < VERSUS_MAX_GARBAGE ? v->incoming[p] : VERSUS_MAX_GARBAGE;
+        add_garbage(g, rows, garbage_random(v) % g->board.width);
+        v->incoming[p] -= rows;
+    }
+}
+
+/* --- Rollback --- */
+
+void rollback_init(Rollback *s, int local, uint64_t seed, int width, int height) {
+    memset(s, 0, sizeof(*s));
+    versus_init(&s->state, seed, width, height);
+    s->local = local;
+
+    /* Nobody presses anything in the first VERSUS_DELAY frames */
+    s->local_next = VERSUS_DELAY;
+    s->remote_next = VERSUS_DELAY;
+    s->mispredicted = -1;
+}
+
+void rollback_free(Rollback *s) {
+    versus_free(&s->state);
+    for (int i = 0; i < VERSUS_WINDOW; i++) versus_free(&s->saved[i]);
+}
+
+int rollback_can_advance(const Rollback *s) {
+    /* After the next local input, every frame from the oldest one we may
+       rewind to or resend must still have its slot */
+    int oldest = s->remote_next < s->remote_ack ? s->remote_next : s->remote_ack;
+    return s->local_next + 1 - oldest <= VERSUS_WINDOW;
+}
+
+void rollback_add_local(Rollback *s, uint8_t mask) {
+    s->inputs[s->local][VERSUS_SLOT(s->local_next)] = mask;
+    s->local_next++;
+}
+
+void rollback_add_remote(Rollback *s, int frame, uint8_t mask) {
+    if (frame != s->remote_next || frame - s->state.frame >= VERSUS_WINDOW) return;
+
+    uint8_t *slot = &s->inputs[1 - s->local][VERSUS_SLOT(frame)];
+    if (frame < s->state.frame && *slot != mask && s->mispredicted < 0) s->mispredicted = frame;
+    *slot = mask;
+    s->remote_next++;
+}
+
+void rollback_ack(Rollback *s, int frame) {
+    if (frame > s->remote_ack) s->remote_ack = frame;
+}
+
+/* Snapshot, then simulate the present frame with whatever inputs the
+   slots hold. */
+static void step_frame(Rollback *s) {
+    int slot = VERSUS_SLOT(s->state.frame);
+    uint8_t inputs[2] = { s->inputs[0][slot], s->inputs[1][slot] };
+    versus_copy(&s->saved[slot], &s->state);
+    versus_step(&s->state, inputs);
+}
+
+int rollback_sync(Rollback *s) {
+    int from = s->mispredicted;
+    if (from < 0) return 0;
+    s->mispredicted = -1;
+
+    int to = s->state.frame;
+    versus_copy(&s->state, &s->saved[VERSUS_SLOT(from)]);
+    while (s->state.frame < to) step_frame(s);
+    return to - from;
+}
+
+void rollback_advance(Rollback *s) {
+    int frame = s->state.frame;
+    if (frame >= s->remote_next) s->inputs[1 - s->local][VERSUS_SLOT(frame)] = 0;
+    step_frame(s);
+}
@@ -0,0 +1,93 @@
+#ifndef VERSUS_H
+#define VERSUS_H
+
+/*
+ * Two-player versus on top of the headless core.
+ *
+ * A Versus holds both players' games and steps them together in fixed
+ * frames of virtual time. Line clears earn garbage that cancels the
+ * sender's own incoming rows first and otherwise rises under the
+ * opponent's stack when their next piece locks. Everything is a function
+ * of the seed and the two input streams, so both peers can simulate both
+ * games.
+ *
+ * A Rollback session runs one side of a networked match: it steps the
+ * present frame with the opponent's input predicted, keeps a snapshot per
+ * frame, and rewinds and re-simulates when a late input turns out to
+ * differ from the prediction. Only inputs cross the network.
+ */
+
+#include <stdint.h>
+
+#include "tetris.h"
+
+#define VERSUS_HZ 200
+#define VERSUS_FRAME_US (1000000 / VERSUS_HZ)
+#define VERSUS_DELAY 1          /* frames between a key and the frame it lands in */
+#define VERSUS_WINDOW 32        /* frames a side may run ahead of the other; power of two */
+#define VERSUS_MAX_GARBAGE 8    /* garbage rows inserted per lock */
+
+typedef struct {
+    TetrisGame games[2];
+    int incoming[2];    /* garbage rows queued under each player */
+    uint64_t rng;       /* garbage hole columns */
+    int frame;          /* frames simulated so far */
+} Versus;
+
+/* Both games get the same seed, so both players see the same pieces. */
+void versus_init(Versus *v, uint64_t seed, int width, int height);
+void versus_free(Versus *v);
+/* Same contract as copy_game(). */
+void versus_copy(Versus *dst, const Versus *src);
+
+/* Simulate one frame. inputs[p] has bit (1 << INPUT_*) set for each input
+   player p pressed during the frame. Once a game is over only the frame
+   count moves. */
+void versus_step(Versus *v, const uint8_t inputs[2]);
+
+/* -1 while both play, else the winning player, or 2 for a draw. */
+int versus_winner(const Versus *v);
+
+/* Input masks are kept for the last VERSUS_WINDOW frames */
+#define VERSUS_SLOT(frame) ((frame) & (VERSUS_WINDOW - 1))
+
+typedef struct {
+    Versus state;                       /* present, possibly predicted */
+    Versus saved[VERSUS_WINDOW];        /* state at the start of each recent frame */
+    uint8_t inputs[2][VERSUS_WINDOW];   /* by player and VERSUS_SLOT(frame) */
+    int local;                          /* which player we are */
+
+    int local_next;     /* local inputs are known for frames below this */
+    int remote_next;    /* remote inputs are confirmed for frames below this */
+    int remote_ack;     /* the peer has our inputs for frames below this */
+    int mispredicted;   /* earliest simulated frame whose prediction was wrong, -1 if none */
+} Rollback;
+
+void rollback_init(Rollback *s, int local, uint64_t seed, int width, int height);
+void rollback_free(Rollback *s);
+
+/* Whether the present frame can be simulated without outrunning the
+   snapshots or the inputs the peer has yet to acknowledge. */
+int rollback_can_advance(const Rollback *s);
+
+/* Queue the local input for frame local_next, VERSUS_DELAY frames ahead
+   of the present. */
+void rollback_add_local(Rollback *s, uint8_t mask);
+
+/* Confirm the remote input for `frame`. Frames already confirmed are
+   ignored, as is anything past remote_next, so resent ranges are
+   harmless. */
+void rollback_add_remote(Rollback *s, int frame, uint8_t mask);
+
+/* The peer has our inputs for frames below `frame`. */
+void rollback_ack(Rollback *s, int frame);
+
+/* Rewind to the earliest mispredicted frame and re-simulate up to the
+   present. Returns the number of frames re-simulated, 0 if none. */
+int rollback_sync(Rollback *s);
+
+/* Simulate the present frame, predicting the remote input as idle where
+   it is not yet confirmed. */
+void rollback_advance(Rollback *s);
+
+#endif